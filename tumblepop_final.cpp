@@ -14,8 +14,17 @@
 #include <array>
 #include <fstream>
 #include <sstream>
+#include <iomanip>
 #include <map>
+#include <deque>
+#include <algorithm>
 #include <tuple>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <memory>
+#include <sys/stat.h>
 
 using namespace sf;
 using namespace std;
@@ -28,14 +37,27 @@ namespace
     const int SCREEN_WIDTH = 1136;
     const int SCREEN_HEIGHT = 896;
     const int CELL_SIZE = 64;
-    const int LEVEL_HEIGHT = 14;
-    const int LEVEL_WIDTH = 18;
+    const int DEFAULT_LEVEL_HEIGHT = 14; // size of a level file without a map block
+    const int DEFAULT_LEVEL_WIDTH = 18;
+    const int CHUNK_CELLS = 16; // terrain chunk edge: collision storage, render culling, sim rate
+    const int FAR_SIM_STRIDE = 4; // enemies outside the camera's chunks update every Nth tick
 
     const float GRAVITY = 0.8f;
     const float TERMINAL_VELOCITY = 15.0f;
     const float JUMP_STRENGTH = -18.0f;
     const float GROUND_SNAP_PX = 12.0f;
 
+    // Simulation runs in fixed steps; per-step physics constants above assume 60 Hz
+    const float FIXED_DT = 1.0f / 60.0f;
+    const float MAX_FRAME_TIME = 0.25f; // drop sim time after long stalls
+
+    // Hard caps for the dense pools (spawns past them are dropped); the particle
+    // system only reserves PARTICLE_POOL and still grows past it
+    const int PROJECTILE_POOL = 64;
+    const int ENEMY_PROJECTILE_POOL = 128;
+    const int EFFECT_POOL = 256;
+    const int PARTICLE_POOL = 4096;
+
     const int PLAYER_FRAME_WIDTH = 96;
     const int PLAYER_FRAME_HEIGHT = 96;
     const float PLAYER_SCALE = 1.95f; // ENHANCED: Larger, more prominent player
@@ -61,550 +83,2493 @@ namespace
     const float CHAR_SELECT_BREATHE_SCALE = 0.05f; // Breathing animation scale
 }
 
-static inline int platformTopY(int row)
+// ============================================================================
+// RANDOM
+// ============================================================================
+// PCG32: 64-bit state, 32-bit output. Each stream has its own increment, so
+// streams seeded with the same value still produce unrelated sequences.
+class Rng
 {
-    int y = row * CELL_SIZE;
-    if (row == 11)
-        y -= 22;
-    return y;
-}
+public:
+    explicit Rng(uint64_t seed = 0x853c49e6748fea9bULL, uint64_t stream = 0) { reseed(seed, stream); }
 
-static inline int enemyPlatformYOffset(int row)
-{
-    return (row == 11) ? -22 : 0;
-}
+    void reseed(uint64_t seed, uint64_t stream)
+    {
+        state = 0;
+        inc = (stream << 1u) | 1u;
+        next();
+        state += seed;
+        next();
+    }
+
+    uint32_t next()
+    {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + inc;
+        uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+        uint32_t rot = (uint32_t)(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+    }
+
+    // Uniform integer in [0, n); stands in for rand() % n
+    int below(int n)
+    {
+        if (n <= 1)
+            return 0;
+        return (int)(((uint64_t)next() * (uint32_t)n) >> 32);
+    }
+
+private:
+    uint64_t state;
+    uint64_t inc;
+};
 
+// Independent streams, so cosmetic effects can't shift gameplay rolls and a
+// run can be replayed from its seed
 namespace
 {
-    int slopeOffset[LEVEL_HEIGHT][LEVEL_WIDTH];
+    Rng rngAI;    // enemy decisions and other gameplay rolls
+    Rng rngLevel; // ramp layout and spawn placement
+    Rng rngFx;    // particles, debris and other cosmetics
 }
 
-static inline int platformTopYAt(int row, int col)
+static void seed_rng_streams(uint64_t seed)
 {
-    int base = platformTopY(row);
-    base += enemyPlatformYOffset(row);
-    if (row >= 0 && row < LEVEL_HEIGHT && col >= 0 && col < LEVEL_WIDTH)
-        base += slopeOffset[row][col];
-    return base;
+    rngAI.reseed(seed, 1);
+    rngLevel.reseed(seed, 2);
+    rngFx.reseed(seed, 3);
 }
 
-const int screen_x = SCREEN_WIDTH;
-const int screen_y = SCREEN_HEIGHT;
-
-void display_level(RenderWindow &window,
-                   char **lvl,
-                   Texture &bgTex,
-                   Sprite &bgSprite,
-                   Texture &blockTexture,
-                   Sprite &blockSprite,
-                   const int height,
-                   const int width,
-                   const int cell_size)
+// ============================================================================
+// LOGGING
+// ============================================================================
+// Runtime messages go through LOG_* macros into a fixed ring of line slots
+// that a background thread drains to stdout, so the game thread never blocks
+// on a console flush. Levels below LOG_LEVEL compile to dead code; build with
+// -DLOG_LEVEL=0 to get the per-shot/per-enemy debug lines back.
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_OFF 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+class Logger
 {
-    bgSprite.setTexture(bgTex);
-    bgSprite.setScale((float)SCREEN_WIDTH / bgTex.getSize().x,
-                      (float)SCREEN_HEIGHT / bgTex.getSize().y);
-    window.draw(bgSprite);
-
-    for (int i = 0; i < height; i++)
+public:
+    static Logger &instance()
     {
-        for (int j = 0; j < width; j++)
-        {
-            if (lvl[i][j] == '#')
-            {
-                if (blockTexture.getSize().x > 0)
-                {
-                    blockSprite.setTexture(blockTexture);
-                    blockSprite.setTextureRect(IntRect(0, 0, (int)blockTexture.getSize().x, (int)blockTexture.getSize().y));
-                    blockSprite.setPosition(j * cell_size, platformTopYAt(i, j));
-                    window.draw(blockSprite);
-                }
-                else
-                {
-                    // Texture missing: skip to remain within allowed API
-                }
-            }
-        }
+        static Logger logger;
+        return logger;
     }
-}
 
-void player_gravity(char **lvl,
-                    float &offset_y,
-                    float &velocityY,
-                    bool &onGround,
-                    const float &gravity,
-                    float &terminal_Velocity,
-                    float &player_x,
-                    float &player_y,
-                    const int cell_size,
-                    int &Pheight,
-                    int &Pwidth)
-{
-    offset_y = player_y;
-    offset_y += velocityY;
+    ~Logger() { stop(); }
 
-    int by = (int)((offset_y + Pheight) / cell_size);
-    int bl = (int)(player_x / cell_size);
-    int br = (int)((player_x + Pwidth) / cell_size);
-    int bm = (int)((player_x + Pwidth / 2.0f) / cell_size);
+    void start()
+    {
+        if (running)
+            return;
+        running = true;
+        drainThread.launch();
+    }
 
-    char bottom_left_down = (by >= 0 && by < LEVEL_HEIGHT && bl >= 0 && bl < LEVEL_WIDTH) ? lvl[by][bl] : ' ';
-    char bottom_right_down = (by >= 0 && by < LEVEL_HEIGHT && br >= 0 && br < LEVEL_WIDTH) ? lvl[by][br] : ' ';
-    char bottom_mid_down = (by >= 0 && by < LEVEL_HEIGHT && bm >= 0 && bm < LEVEL_WIDTH) ? lvl[by][bm] : ' ';
+    // Joins the drain thread and writes out whatever is still queued
+    void stop()
+    {
+        if (running)
+        {
+            running = false;
+            drainThread.wait();
+        }
+        drain();
+    }
 
-    if (bottom_left_down == '#' || bottom_mid_down == '#' || bottom_right_down == '#')
+    // Blocks until every line queued so far has been written. Call it before
+    // writing to cout directly so the two streams come out in order.
+    void flush()
     {
-        onGround = true;
+        if (!running)
+        {
+            drain();
+            return;
+        }
+        size_t target = writeIndex.load(std::memory_order_acquire);
+        while (readIndex.load(std::memory_order_acquire) < target)
+            sf::sleep(milliseconds(1));
     }
-    else
+
+    // Single producer (the game thread). A full ring drops the line rather
+    // than stall the frame; the drain reports how many were lost.
+    void push(const std::string &text)
     {
-        player_y = offset_y;
-        onGround = false;
+        size_t head = writeIndex.load(std::memory_order_relaxed);
+        if (head - readIndex.load(std::memory_order_acquire) >= RING_SIZE)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        Slot &slot = ring[head % RING_SIZE];
+        slot.length = text.copy(slot.text, sizeof(slot.text));
+        writeIndex.store(head + 1, std::memory_order_release);
+        if (!running)
+            drain();
     }
 
-    if (!onGround)
+private:
+    static const size_t RING_SIZE = 1024;
+
+    struct Slot
     {
-        velocityY += gravity;
-        if (velocityY >= terminal_Velocity)
-            velocityY = terminal_Velocity;
+        char text[240];
+        size_t length;
+    };
+
+    Logger() : drainThread(&Logger::drainLoop, this), running(false), writeIndex(0), readIndex(0), dropped(0) {}
+
+    void drainLoop()
+    {
+        while (running)
+        {
+            if (!drain())
+                sf::sleep(milliseconds(5));
+        }
     }
-    else
+
+    bool drain()
     {
-        velocityY = 0;
+        size_t tail = readIndex.load(std::memory_order_relaxed);
+        size_t head = writeIndex.load(std::memory_order_acquire);
+        size_t lost = dropped.exchange(0, std::memory_order_relaxed);
+        if (tail == head && lost == 0)
+            return false;
+        for (; tail != head; tail++)
+        {
+            const Slot &slot = ring[tail % RING_SIZE];
+            cout.write(slot.text, slot.length);
+            cout.put('\n');
+        }
+        readIndex.store(tail, std::memory_order_release);
+        if (lost)
+            cout << "[WARN] Log ring full, dropped " << lost << " lines\n";
+        cout.flush();
+        return true;
     }
-}
 
-enum GameState
-{
-    CHARACTER_SELECT,
-    LEVEL_1,
-    LEVEL_2,
-    GAME_OVER,
-    VICTORY
+    Slot ring[RING_SIZE];
+    Thread drainThread;
+    std::atomic<bool> running;
+    std::atomic<size_t> writeIndex;
+    std::atomic<size_t> readIndex;
+    std::atomic<size_t> dropped;
 };
 
-enum PowerupType
+#define LOG_AT(expr)                              \
+    do                                            \
+    {                                             \
+        std::ostringstream log_line_;             \
+        log_line_ << expr;                        \
+        Logger::instance().push(log_line_.str()); \
+    } while (0)
+
+// Disabled levels still type-check their arguments but sit behind if (false),
+// so nothing is formatted or queued
+#define LOG_SKIP(expr)                    \
+    do                                    \
+    {                                     \
+        if (false)                        \
+        {                                 \
+            std::ostringstream log_line_; \
+            log_line_ << expr;            \
+        }                                 \
+    } while (0)
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(expr) LOG_AT(expr)
+#else
+#define LOG_DEBUG(expr) LOG_SKIP(expr)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(expr) LOG_AT(expr)
+#else
+#define LOG_INFO(expr) LOG_SKIP(expr)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(expr) LOG_AT(expr)
+#else
+#define LOG_WARN(expr) LOG_SKIP(expr)
+#endif
+
+static inline int platformTopY(int row)
 {
-    POWERUP_SPEED,
-    POWERUP_RANGE,
-    POWERUP_POWER,
-    POWERUP_LIFE
-};
+    int y = row * CELL_SIZE;
+    if (row == 11)
+        y -= 22;
+    return y;
+}
 
-enum PlayerAnimState
+static inline int enemyPlatformYOffset(int row)
 {
-    P_IDLE,
-    P_RUN,
-    P_SLIDE,
-    P_JUMP_START,
-    P_JUMP_MID,
-    P_JUMP_PEAK,
-    P_FALL,
-    P_ALERT,
-    P_LAND,
-    P_CROUCH,
-    P_HURT,
-    P_KNOCKDOWN,
-    P_VICTORY,
-    P_DEATH_FADE,
-    P_POWER_RUN,
-    P_JETPACK,
-    P_SHOOT,
-    P_SHOOT_FORWARD,
-    P_SHOOT_SIDE
-};
+    return (row == 11) ? -22 : 0;
+}
+
+namespace
+{
+    // Size of the level being played, in cells; set by Game::buildLevel()
+    int levelWidth = DEFAULT_LEVEL_WIDTH;
+    int levelHeight = DEFAULT_LEVEL_HEIGHT;
+}
+
+// Gameplay bounds in pixels. Menus and the HUD stay in screen space.
+static inline int world_width() { return levelWidth * CELL_SIZE; }
+static inline int world_height() { return levelHeight * CELL_SIZE; }
 
 // ============================================================================
-// PARTICLE SYSTEM
+// TILE GRID
 // ============================================================================
-class Particle
+// A level's cells and per-cell ramp offsets, row-major, sized by the level
+// file. buildLevel() edits its copy (random ramps) before baking a TileGrid.
+struct TileMap
 {
-public:
-    Vector2f position;
-    Vector2f velocity;
-    Color color;
-    float lifetime;
-    float maxLifetime;
-    float size;
-    bool active;
+    int width, height;
+    std::vector<char> cells;
+    std::vector<int32_t> slope;
 
-    Particle() : active(false) {}
+    TileMap(int w = DEFAULT_LEVEL_WIDTH, int h = DEFAULT_LEVEL_HEIGHT) { resize(w, h); }
 
-    Particle(Vector2f pos, Vector2f vel, Color col, float life, float sz = 3.0f)
+    void resize(int w, int h)
     {
-        position = pos;
-        velocity = vel;
-        color = col;
-        lifetime = life;
-        maxLifetime = life;
-        size = sz;
-        active = true;
+        width = w;
+        height = h;
+        cells.assign((size_t)w * h, ' ');
+        slope.assign((size_t)w * h, 0);
     }
 
-    // Updates projectile animation and movement each frame
-    void update(float dt)
-    {
-        if (!active)
-            return;
+    bool inside(int row, int col) const { return row >= 0 && row < height && col >= 0 && col < width; }
+    char &at(int row, int col) { return cells[(size_t)row * width + col]; }
+    char at(int row, int col) const { return cells[(size_t)row * width + col]; }
+    int32_t &slopeAt(int row, int col) { return slope[(size_t)row * width + col]; }
+    int32_t slopeAt(int row, int col) const { return slope[(size_t)row * width + col]; }
+};
 
-        position += velocity * dt * 60.0f;
-        velocity.y += GRAVITY * 0.3f;
-        lifetime -= dt;
+enum TileFlag
+{
+    TILE_SOLID = 1 << 0,   // '#': stood on, and stops heads coming from below
+    TILE_ONE_WAY = 1 << 1, // ramp cells: stood on, passed through from below
+    TILE_SLOPE = 1 << 2,   // '/', '\\' and 'S'
+    TILE_STAIR = 1 << 3,   // 'S' only; its direction comes from its neighbours
+    TILE_FLOOR = TILE_SOLID | TILE_ONE_WAY
+};
 
-        if (lifetime <= 0)
-        {
-            active = false;
+static inline unsigned tile_flags(char cell)
+{
+    if (cell == '#')
+        return TILE_SOLID;
+    if (cell == '/' || cell == '\\')
+        return TILE_ONE_WAY | TILE_SLOPE;
+    if (cell == 'S')
+        return TILE_ONE_WAY | TILE_SLOPE | TILE_STAIR;
+    return 0;
+}
+
+// Collision properties of every cell, baked from the TileMap once per
+// buildLevel(). Cells live in CHUNK_CELLS-square chunks; inside a chunk each
+// property is a bit plane with one mask per row, so a run of columns costs one
+// AND per chunk it crosses. A ring of empty chunks surrounds the level and
+// indices are clamped into it, so samples off the level read as empty without
+// per-sample bounds checks.
+class TileGrid
+{
+public:
+    static const int PLANES = 4;
+    static_assert(CHUNK_CELLS <= 32, "a chunk row must fit one plane mask");
+
+    TileGrid() { build(TileMap()); }
+
+    void build(const TileMap &map)
+    {
+        cols = map.width;
+        rows = map.height;
+        chunkCols = (cols + CHUNK_CELLS - 1) / CHUNK_CELLS + 2;
+        chunkRows = (rows + CHUNK_CELLS - 1) / CHUNK_CELLS + 2;
+        chunks.assign((size_t)chunkCols * chunkRows, Chunk());
+        for (int pr = 0; pr < chunkRows * CHUNK_CELLS; pr++)
+        {
+            for (int pc = 0; pc < chunkCols * CHUNK_CELLS; pc++)
+            {
+                int r = pr - CHUNK_CELLS;
+                int c = pc - CHUNK_CELLS;
+                bool inside = map.inside(r, c);
+                unsigned flags = inside ? tile_flags(map.at(r, c)) : 0;
+                Chunk &k = chunkAt(pr, pc);
+                int lr = pr % CHUNK_CELLS;
+                int lc = pc % CHUNK_CELLS;
+                for (int b = 0; b < PLANES; b++)
+                    if (flags & (1u << b))
+                        k.planes[b][lr] |= 1u << lc;
+                k.surface[lr][lc] = platformTopY(r) + enemyPlatformYOffset(r) + (inside ? map.slopeAt(r, c) : 0);
+            }
         }
     }
 
-    void draw(RenderWindow &window)
+    int width() const { return cols; }
+    int height() const { return rows; }
+    // Chunks covering the level itself, not the empty ring
+    int chunksWide() const { return chunkCols - 2; }
+    int chunksHigh() const { return chunkRows - 2; }
+
+    // All flags of one cell
+    unsigned at(int row, int col) const
     {
-        if (!active)
-            return;
+        int pr = padRow(row);
+        int pc = padCol(col);
+        const Chunk &k = chunkAt(pr, pc);
+        unsigned flags = 0;
+        for (int b = 0; b < PLANES; b++)
+            flags |= ((k.planes[b][pr % CHUNK_CELLS] >> (pc % CHUNK_CELLS)) & 1u) << b;
+        return flags;
+    }
 
-        float alpha = (lifetime / maxLifetime) * 255;
-        CircleShape particle(size);
-        particle.setPosition(position);
-        particle.setFillColor(Color(color.r, color.g, color.b, (Uint8)alpha));
-        window.draw(particle);
+    // True when the cell has any of flags
+    bool has(int row, int col, unsigned flags) const
+    {
+        int pr = padRow(row);
+        int pc = padCol(col);
+        return (rowMask(chunkAt(pr, pc), pr % CHUNK_CELLS, flags) >> (pc % CHUNK_CELLS)) & 1u;
     }
-};
 
-class ParticleSystem
-{
-public:
-    vector<Particle> particles;
+    // True when any cell of row in [colFirst, colLast] has any of flags
+    bool any(int row, int colFirst, int colLast, unsigned flags) const
+    {
+        return count(row, colFirst, colLast, flags, true) > 0;
+    }
 
-    void addParticle(Particle p)
+    // Number of cells of row in [colFirst, colLast] having any of flags
+    int count(int row, int colFirst, int colLast, unsigned flags) const
     {
-        particles.push_back(p);
+        return count(row, colFirst, colLast, flags, false);
     }
 
-    void emit(Vector2f position, Color color, int count = 10)
+    // Top y of the cell's walkable surface, ramp offsets included
+    int surfaceY(int row, int col) const
     {
-        for (int i = 0; i < count; i++)
-        {
-            float angle = (rand() % 360) * 3.14159f / 180.0f;
-            float speed = 2.0f + (rand() % 100) / 50.0f;
-            Vector2f vel(cos(angle) * speed, sin(angle) * speed);
-            addParticle(Particle(position, vel, color, 0.5f + (rand() % 50) / 100.0f));
-        }
+        int pr = padRow(row);
+        int pc = padCol(col);
+        return chunkAt(pr, pc).surface[pr % CHUNK_CELLS][pc % CHUNK_CELLS];
     }
 
-    void update(float dt)
+private:
+    struct Chunk
     {
-        for (size_t i = 0; i < particles.size(); i++)
-        {
-            particles[i].update(dt);
-        }
+        uint32_t planes[PLANES][CHUNK_CELLS];
+        int surface[CHUNK_CELLS][CHUNK_CELLS];
+    };
+
+    int padRow(int row) const { return std::min(std::max(row + CHUNK_CELLS, 0), chunkRows * CHUNK_CELLS - 1); }
+    int padCol(int col) const { return std::min(std::max(col + CHUNK_CELLS, 0), chunkCols * CHUNK_CELLS - 1); }
+
+    Chunk &chunkAt(int pr, int pc) { return chunks[(size_t)(pr / CHUNK_CELLS) * chunkCols + pc / CHUNK_CELLS]; }
+    const Chunk &chunkAt(int pr, int pc) const { return chunks[(size_t)(pr / CHUNK_CELLS) * chunkCols + pc / CHUNK_CELLS]; }
 
-        // Remove inactive particles
-        particles.erase(
-            remove_if(particles.begin(), particles.end(),
-                      [](const Particle &p)
-                      { return !p.active; }),
-            particles.end());
+    static uint32_t rowMask(const Chunk &k, int localRow, unsigned flags)
+    {
+        uint32_t mask = 0;
+        for (int b = 0; b < PLANES; b++)
+            if (flags & (1u << b))
+                mask |= k.planes[b][localRow];
+        return mask;
     }
 
-    void draw(RenderWindow &window)
+    int count(int row, int colFirst, int colLast, unsigned flags, bool stopAtFirst) const
     {
-        for (size_t i = 0; i < particles.size(); i++)
-        {
-            particles[i].draw(window);
+        if (colFirst > colLast)
+            return 0; // empty span; the chunk masks below assume first <= last
+        int pr = padRow(row);
+        int first = padCol(colFirst);
+        int last = padCol(colLast);
+        int n = 0;
+        for (int cx = first / CHUNK_CELLS; cx <= last / CHUNK_CELLS; cx++)
+        {
+            int lo = std::max(first - cx * CHUNK_CELLS, 0);
+            int hi = std::min(last - cx * CHUNK_CELLS, CHUNK_CELLS - 1);
+            uint32_t span = (uint32_t)((2ull << hi) - (1ull << lo));
+            uint32_t bits = rowMask(chunkAt(pr, cx * CHUNK_CELLS), pr % CHUNK_CELLS, flags) & span;
+            for (; bits; bits &= bits - 1)
+            {
+                n++;
+                if (stopAtFirst)
+                    return n;
+            }
         }
+        return n;
     }
+
+    int cols, rows;
+    int chunkCols, chunkRows;
+    std::vector<Chunk> chunks;
 };
 
 // ============================================================================
-// SCORE MANAGER
+// PLATFORM GRAPH
 // ============================================================================
-class ScoreManager
+// Navigation tables for the '#' tiles, rebuilt whenever the level is built.
+// Enemy AI used to walk the map tile by tile for platform edges and jump
+// targets every frame; these answer the same questions with one lookup and
+// return exactly what the old walks returned, including their quirks (a walk
+// stops on the first open tile and never steps past column 0 / the last
+// column, and out-of-range queries come back unchanged).
+class PlatformGraph
 {
 public:
-    int score;
-    int combo;
-    float comboTimer;
-    bool noDamage;
-    float levelTime;
-    float scoreAnimTimer; // MASTERCLASS: For animated score pop effect
-
-    ScoreManager() { reset(); }
-
-    void reset()
+    // Jump/drop from a segment to another: target segment id and the columns
+    // of the source segment the jump starts from
+    struct Link
     {
-        score = 0;
-        combo = 0;
-        comboTimer = 0;
-        noDamage = true;
-        levelTime = 0;
-        scoreAnimTimer = 0;
-    }
+        int target;
+        int colFirst, colLast;
+    };
 
-    void resetLevel()
+    // A maximal run of '#' on one row, with the segments reachable from it by
+    // the enemy jump rule (nearest platform above in the same column, else the
+    // nearest below)
+    struct Segment
     {
-        combo = 0;
-        comboTimer = 0;
-        noDamage = true;
-        levelTime = 0;
-        scoreAnimTimer = 0;
-    }
+        int row, colStart, colEnd;
+        std::vector<Link> links;
+    };
 
-    void update(float dt)
+    PlatformGraph() : rows(0), cols(0) {}
+
+    void build(const TileGrid &tiles)
     {
-        levelTime += dt;
-        if (comboTimer > 0)
+        rows = tiles.height();
+        cols = tiles.width();
+        size_t cells = (size_t)rows * cols;
+        solid.assign(cells, 0);
+        left.assign(cells, 0);
+        right.assign(cells, 0);
+        upTo.assign(cells, -1);
+        downFrom.assign(cells, -1);
+        segmentId.assign(cells, -1);
+
+        for (int r = 0; r < rows; r++)
+            for (int c = 0; c < cols; c++)
+                solid[cell(r, c)] = tiles.has(r, c, TILE_SOLID);
+
+        for (int r = 0; r < rows; r++)
         {
-            comboTimer -= dt;
-            if (comboTimer <= 0)
+            for (int c = 0; c < cols; c++)
+                left[cell(r, c)] = (c > 0 && solid[cell(r, c)]) ? left[cell(r, c - 1)] : c;
+            for (int c = cols - 1; c >= 0; c--)
+                right[cell(r, c)] = (c < cols - 1 && solid[cell(r, c)]) ? right[cell(r, c + 1)] : c;
+        }
+
+        for (int c = 0; c < cols; c++)
+        {
+            int last = -1;
+            for (int r = 0; r < rows; r++)
             {
-                combo = 0;
+                if (solid[cell(r, c)])
+                    last = r;
+                upTo[cell(r, c)] = last;
+            }
+            int next = -1;
+            for (int r = rows - 1; r >= 0; r--)
+            {
+                if (solid[cell(r, c)])
+                    next = r;
+                downFrom[cell(r, c)] = next;
             }
         }
-        // MASTERCLASS: Update score animation timer
-        if (scoreAnimTimer > 0)
-            scoreAnimTimer -= dt;
-    }
 
-    void addCapturePoints(int points, int currentCapturedCount)
-    {
-        score += points;
-        scoreAnimTimer = 0.3f; // MASTERCLASS: Trigger score pop
-        // CONSOLE OUTPUT (Requirement 3)
-        // "Captured 1" (No max capacity)
-        cout << "Captured " << currentCapturedCount << endl;
-    }
-
-    void addDefeatPoints(int basePoints)
-    {
-        int points = basePoints * 2;
-        if (combo >= 5)
+        segs.clear();
+        for (int r = 0; r < rows; r++)
         {
-            points = (int)(points * 2.0f);
+            for (int c = 0; c < cols; c++)
+            {
+                segmentId[cell(r, c)] = -1;
+                if (!solid[cell(r, c)])
+                    continue;
+                if (c > 0 && solid[cell(r, c - 1)])
+                    segmentId[cell(r, c)] = segmentId[cell(r, c - 1)];
+                else
+                {
+                    segmentId[cell(r, c)] = (int)segs.size();
+                    segs.push_back(Segment{r, c, c, std::vector<Link>()});
+                }
+                segs[segmentId[cell(r, c)]].colEnd = c;
+            }
         }
-        else if (combo >= 3)
+
+        for (size_t i = 0; i < segs.size(); i++)
         {
-            points = (int)(points * 1.5f);
+            Segment &seg = segs[i];
+            for (int c = seg.colStart; c <= seg.colEnd; c++)
+            {
+                int target = jumpRow(seg.row, c);
+                int id = (target >= 0) ? segmentId[cell(target, c)] : -1;
+                if (id < 0)
+                    continue;
+                size_t k = 0;
+                while (k < seg.links.size() && seg.links[k].target != id)
+                    k++;
+                if (k == seg.links.size())
+                    seg.links.push_back(Link{id, c, c});
+                seg.links[k].colLast = c;
+            }
         }
-        score += points;
-        combo++;
-        comboTimer = 3.0f;
-        scoreAnimTimer = 0.4f; // MASTERCLASS: Trigger score pop
     }
 
-    void addMultiKillBonus(int count)
-    {
-        int bonus = 0;
-        if (count >= 3)
-            bonus = 500;
-        else if (count == 2)
-            bonus = 200;
-        if (bonus > 0)
-            score += bonus;
-    }
+    bool isSolid(int row, int col) const { return inside(row, col) && solid[cell(row, col)]; }
 
-    void addVacuumBurstBonus(int count)
+    // End column of "while (c > 0 && solid) c--" started at col
+    int walkLeft(int row, int col) const { return inside(row, col) ? left[cell(row, col)] : col; }
+    // End column of "while (c < last column && solid) c++" started at col
+    int walkRight(int row, int col) const { return inside(row, col) ? right[cell(row, col)] : col; }
+
+    // Nearest solid row at or above row in col, or -1
+    int solidAtOrAbove(int row, int col) const
     {
-        if (count >= 3)
-            score += 300;
+        if (col < 0 || col >= cols || row < 0)
+            return -1;
+        return upTo[cell(std::min(row, rows - 1), col)];
     }
 
-    void addAerialBonus()
+    // Nearest solid row at or below row in col, or -1
+    int solidAtOrBelow(int row, int col) const
     {
-        score += 150;
+        if (col < 0 || col >= cols || row >= rows)
+            return -1;
+        return downFrom[cell(std::max(row, 0), col)];
     }
 
-    void addCharacterBonus(const std::string &label)
+    // Row an enemy standing on currentRow jumps to from col: the platform
+    // above if there is one, otherwise the one below; -1 for none
+    int jumpRow(int currentRow, int col) const
     {
-        score += 500;
-        cout << "[CHARACTER BONUS] " << label << " +500 (Total: " << score << ")" << endl;
+        int up = solidAtOrAbove(currentRow - 1, col);
+        return (up >= 0) ? up : solidAtOrBelow(currentRow + 1, col);
     }
 
-    void playerHit()
+    int segmentAt(int row, int col) const { return inside(row, col) ? segmentId[cell(row, col)] : -1; }
+    const std::vector<Segment> &segments() const { return segs; }
+
+private:
+    bool inside(int row, int col) const
     {
-        score -= 50;
-        if (score < 0)
-            score = 0;
-        noDamage = false;
-        combo = 0;
-        comboTimer = 0;
+        return row >= 0 && row < rows && col >= 0 && col < cols;
     }
 
-    void playerDeath()
+    int cell(int row, int col) const { return row * cols + col; }
+
+    int rows, cols;
+    std::vector<char> solid;
+    std::vector<int> left;
+    std::vector<int> right;
+    std::vector<int> upTo;
+    std::vector<int> downFrom;
+    std::vector<int> segmentId;
+    std::vector<Segment> segs;
+};
+
+// Shared route toward one goal segment (the player's). A BFS over the reversed
+// links gives every segment its distance and the link to take next, so any
+// number of enemies follow the player with one lookup each. The BFS only runs
+// again when the goal segment changes.
+class FlowField
+{
+public:
+    FlowField() : goal(-1) {}
+
+    // The graph changed; forget routes and reverse links
+    void invalidate()
     {
-        score -= 200;
-        if (score < 0)
-            score = 0;
+        goal = -1;
+        incoming.clear();
+        dist.clear();
+        via.clear();
     }
 
-    void levelComplete(int level)
+    // Returns true when the field was recomputed
+    bool retarget(const PlatformGraph &graph, int goalSegment)
     {
-        if (level == 1)
+        const std::vector<PlatformGraph::Segment> &segs = graph.segments();
+        if (goalSegment < 0 || goalSegment >= (int)segs.size() || goalSegment == goal)
+            return false;
+        goal = goalSegment;
+
+        if (incoming.size() != segs.size())
         {
-            score += 1000;
-            if (noDamage)
-                score += 1500;
-            if (levelTime < 30)
-                score += 2000;
-            else if (levelTime < 45)
-                score += 1000;
-            else if (levelTime < 60)
-                score += 500;
+            incoming.assign(segs.size(), std::vector<int>());
+            for (size_t i = 0; i < segs.size(); i++)
+                for (size_t k = 0; k < segs[i].links.size(); k++)
+                    incoming[segs[i].links[k].target].push_back((int)i);
         }
-        else
+
+        dist.assign(segs.size(), -1);
+        via.assign(segs.size(), -1);
+        std::vector<int> frontier(1, goal);
+        dist[goal] = 0;
+        for (size_t head = 0; head < frontier.size(); head++)
         {
-            score += 2000;
-            if (noDamage)
-                score += 2500;
-            if (levelTime < 60)
-                score += 3000;
-            else if (levelTime < 90)
-                score += 1500;
-            else if (levelTime < 120)
-                score += 750;
+            int to = frontier[head];
+            for (size_t k = 0; k < incoming[to].size(); k++)
+            {
+                int from = incoming[to][k];
+                if (dist[from] >= 0)
+                    continue;
+                dist[from] = dist[to] + 1;
+                const std::vector<PlatformGraph::Link> &links = segs[from].links;
+                for (size_t l = 0; l < links.size(); l++)
+                    if (links[l].target == to)
+                        via[from] = (int)l;
+                frontier.push_back(from);
+            }
         }
+        return true;
     }
-};
-
-// ============================================================================
-// POWERUP CLASS
-// ============================================================================
-class Powerup
-{
-public:
-    float x, y;
-    PowerupType type;
-    bool active;
-    Sprite sprite;
-    float bobTimer;
-    int animFrames;
-    float animTimer;
-    float animFPS;
-    int frameIndex;
-    std::vector<IntRect> rects;
-    bool useMetaRects;
-    int frameW;
-    int texH;
 
-    Powerup(PowerupType t, float px, float py)
+    // Link to take from segment toward the goal; null on the goal segment,
+    // off the graph or when the goal can't be reached
+    const PlatformGraph::Link *route(const PlatformGraph &graph, int segment) const
     {
-        type = t;
-        x = px;
-        y = py;
-        active = true;
-        bobTimer = 0;
-        animFrames = 1;
-        animTimer = 0;
-        animFPS = 8.0f;
-        frameIndex = 0;
-        useMetaRects = false;
+        if (segment < 0 || segment >= (int)via.size() || via[segment] < 0)
+            return nullptr;
+        return &graph.segments()[segment].links[via[segment]];
     }
 
-    void setupSprite(Texture &tex)
+    int distance(int segment) const
     {
-        sprite.setTexture(tex);
-        sprite.setScale(1.5f, 1.5f);
+        return (segment >= 0 && segment < (int)dist.size()) ? dist[segment] : -1;
+    }
 
-        if (type == POWERUP_SPEED)
-            animFrames = 4;
-        else if (type == POWERUP_POWER)
-            animFrames = 5;
-        else
-            animFrames = max(1u, tex.getSize().x / (unsigned)48);
+private:
+    int goal;
+    std::vector<std::vector<int>> incoming;
+    std::vector<int> dist;
+    std::vector<int> via;
+};
 
-        frameIndex = 0;
-        animTimer = 0;
+namespace
+{
+    PlatformGraph platformGraph; // rebuilt by Game::buildLevel()
+    FlowField playerFlow;        // routes to the player's segment, see updateGameplay()
+}
 
-        frameW = (int)(tex.getSize().x / std::max(1, animFrames));
-        texH = (int)tex.getSize().y;
-        sprite.setTextureRect(IntRect(0, 0, frameW, texH));
-    }
+const int screen_x = SCREEN_WIDTH;
+const int screen_y = SCREEN_HEIGHT;
+
+// Baked terrain for one CHUNK_CELLS square of the level. Blocks and ramp strips
+// stay in separate arrays so every block still draws before any ramp; bounds
+// cover both and are what the renderer tests against the camera.
+struct TerrainChunk
+{
+    VertexArray blocks;
+    VertexArray ramps;
+    FloatRect bounds;
 
-    void applyMetaRects(const std::vector<IntRect> &r)
+    TerrainChunk() : blocks(Quads), ramps(Triangles) {}
+
+    void updateBounds()
     {
-        rects = r;
-        if (!rects.empty())
+        bounds = FloatRect();
+        const VertexArray *layers[2] = {&blocks, &ramps};
+        for (int i = 0; i < 2; i++)
         {
-            animFrames = (int)rects.size();
-            frameIndex = 0;
-            animTimer = 0;
-            sprite.setTextureRect(rects[0]);
-            frameW = rects[0].width;
-            texH = rects[0].height;
-            useMetaRects = true;
+            if (layers[i]->getVertexCount() == 0)
+                continue;
+            FloatRect b = layers[i]->getBounds();
+            if (bounds.width <= 0 && bounds.height <= 0)
+            {
+                bounds = b;
+                continue;
+            }
+            float right = std::max(bounds.left + bounds.width, b.left + b.width);
+            float bottom = std::max(bounds.top + bounds.height, b.top + b.height);
+            bounds.left = std::min(bounds.left, b.left);
+            bounds.top = std::min(bounds.top, b.top);
+            bounds.width = right - bounds.left;
+            bounds.height = bottom - bounds.top;
         }
     }
+};
 
-    void update(float dt)
-    {
-        if (!active)
-            return;
+// Chunk holding cell (row, col); chunks are laid out chunksWide() per row
+static inline int terrain_chunk(const TileGrid &tiles, int row, int col)
+{
+    return (row / CHUNK_CELLS) * tiles.chunksWide() + col / CHUNK_CELLS;
+}
 
-        bobTimer += dt;
-        float bobOffset = sin(bobTimer * 3.0f) * 5.0f;
-        sprite.setPosition(x - (frameW * 1.5f) / 2.0f, y + bobOffset - (texH * 1.5f) / 2.0f);
+// Builds the static terrain layer: one textured quad per '#' cell, batched into
+// its chunk's vertex array so a chunk's blocks go out in one draw call
+void build_tile_mesh(std::vector<TerrainChunk> &terrain,
+                     const TileGrid &tiles,
+                     const Texture &blockTexture,
+                     const int cell_size)
+{
+    terrain.assign((size_t)tiles.chunksWide() * tiles.chunksHigh(), TerrainChunk());
+    if (blockTexture.getSize().x == 0)
+        return; // Texture missing: leave the layer empty
 
-        animTimer += dt;
-        if (animFrames > 1 && animTimer > (1.0f / animFPS))
+    float texW = (float)blockTexture.getSize().x;
+    float texH = (float)blockTexture.getSize().y;
+    for (int i = 0; i < tiles.height(); i++)
+    {
+        for (int j = 0; j < tiles.width(); j++)
         {
-            animTimer = 0;
-            frameIndex = (frameIndex + 1) % animFrames;
-            if (useMetaRects && !rects.empty())
-            {
-                sprite.setTextureRect(rects[frameIndex]);
-            }
-            else
-            {
-                sprite.setTextureRect(IntRect(frameIndex * frameW, 0, frameW, texH));
-            }
+            if (!tiles.has(i, j, TILE_SOLID))
+                continue;
+            float left = (float)(j * cell_size);
+            float top = (float)tiles.surfaceY(i, j);
+            float right = left + cell_size;
+            float bottom = top + cell_size;
+            VertexArray &mesh = terrain[terrain_chunk(tiles, i, j)].blocks;
+            mesh.append(Vertex(Vector2f(left, top), Vector2f(0, 0)));
+            mesh.append(Vertex(Vector2f(right, top), Vector2f(texW, 0)));
+            mesh.append(Vertex(Vector2f(right, bottom), Vector2f(texW, texH)));
+            mesh.append(Vertex(Vector2f(left, bottom), Vector2f(0, texH)));
         }
     }
+}
 
-    bool collidesWith(float px, float py, int pw, int ph)
+// Appends one ramp to the cached ramp layer. The old renderer stamped 2px-wide
+// vertical slices along the ramp, advancing the texture 2px per slice; the same
+// surface is a sheared quad whose U coordinate runs 2px per slice, so the ramp
+// becomes two triangles sampling a repeated block texture.
+void append_ramp_strip(VertexArray &mesh,
+                       float x1, float y1,
+                       float x2, float y2,
+                       float thick,
+                       float texH)
+{
+    float dx = x2 - x1;
+    float dy = y2 - y1;
+    float len = std::max(1.0f, std::sqrt(dx * dx + dy * dy));
+    int steps = std::max(1, (int)(len / 2));
+    float u = steps * 2.0f;
+    // Keep at least one slice of width so vertical runs stay visible
+    if (std::fabs(dx) < 2.0f)
+        x2 = x1 + 2.0f;
+
+    Vertex topA(Vector2f(x1, y1 - thick / 2), Vector2f(0, 0));
+    Vertex botA(Vector2f(x1, y1 + thick / 2), Vector2f(0, texH));
+    Vertex topB(Vector2f(x2, y2 - thick / 2), Vector2f(u, 0));
+    Vertex botB(Vector2f(x2, y2 + thick / 2), Vector2f(u, texH));
+    mesh.append(topA);
+    mesh.append(botA);
+    mesh.append(topB);
+    mesh.append(topB);
+    mesh.append(botA);
+    mesh.append(botB);
+}
+
+// The backdrop is screen-fixed; the blocks of chunks inside view are drawn
+// through it, leaving view set on the window for the rest of the world
+void display_level(RenderWindow &window,
+                   Texture &bgTex,
+                   Sprite &bgSprite,
+                   Texture &blockTexture,
+                   const std::vector<TerrainChunk> &terrain,
+                   const View &view)
+{
+    bgSprite.setTexture(bgTex);
+    bgSprite.setScale((float)SCREEN_WIDTH / bgTex.getSize().x,
+                      (float)SCREEN_HEIGHT / bgTex.getSize().y);
+    window.setView(window.getDefaultView());
+    window.draw(bgSprite);
+
+    // '#' blocks are pre-built by build_tile_mesh(); one draw per visible chunk
+    window.setView(view);
+    FloatRect visible(view.getCenter() - view.getSize() / 2.0f, view.getSize());
+    for (size_t i = 0; i < terrain.size(); i++)
     {
-        return (x < px + pw && x + 48 > px && y < py + ph && y + 48 > py);
+        if (terrain[i].blocks.getVertexCount() > 0 && terrain[i].bounds.intersects(visible))
+            window.draw(terrain[i].blocks, RenderStates(&blockTexture));
     }
-};
+}
 
-// ============================================================================
-// PLAYER CLASS - ENHANCED WITH PROPER ANIMATIONS
-// ============================================================================
-class Player
+void player_gravity(const TileGrid &tiles,
+                    float &offset_y,
+                    float &velocityY,
+                    bool &onGround,
+                    const float &gravity,
+                    float &terminal_Velocity,
+                    float &player_x,
+                    float &player_y,
+                    const int cell_size,
+                    int &Pheight,
+                    int &Pwidth)
 {
-public:
-    float x, y;
-    float velocityX, velocityY;
-    int health;
-    bool isYellow;
-    float speed;
-    float baseSpeed;
-    bool onGround;
-    bool facingRight;
-
-    int vacuumDirection;
-    bool vacuumActive;
-    int capturedEnemies[5];
-    int capturedCount;
-    int maxCapacity;
-    float vacuumRange;
-    float baseVacuumRange;
-    float vacuumAngle;
-    float baseVacuumAngle;
-    float vacuumPower;
+    offset_y = player_y;
+    offset_y += velocityY;
 
-    // Vacuum Animation State
-    int vacuumAnimState; // 0=OFF, 1=GROW, 2=SUSTAIN, 3=SHRINK
-    float vacuumAnimFrame;
-    float vacuumAnimSpeed;
-    float jumpBoostTimer;
+    int by = (int)((offset_y + Pheight) / cell_size);
+    int bl = (int)(player_x / cell_size);
+    int br = (int)((player_x + Pwidth) / cell_size);
 
-    float speedBoostTimer;
-    float rangeBoostTimer;
-    float powerBoostTimer;
+    if (tiles.any(by, bl, br, TILE_SOLID))
+    {
+        onGround = true;
+    }
+    else
+    {
+        player_y = offset_y;
+        onGround = false;
+    }
 
-    int animFrame;
-    float animTimer;
-    PlayerAnimState animState;
-    PlayerAnimState prevAnimState;
+    if (!onGround)
+    {
+        velocityY += gravity;
+        if (velocityY >= terminal_Velocity)
+            velocityY = terminal_Velocity;
+    }
+    else
+    {
+        velocityY = 0;
+    }
+}
+
+enum GameState
+{
+    CHARACTER_SELECT,
+    LEVEL_1,
+    LEVEL_2,
+    GAME_OVER,
+    VICTORY
+};
+
+enum PowerupType
+{
+    POWERUP_SPEED,
+    POWERUP_RANGE,
+    POWERUP_POWER,
+    POWERUP_LIFE
+};
+
+enum PlayerAnimState
+{
+    P_IDLE,
+    P_RUN,
+    P_SLIDE,
+    P_JUMP_START,
+    P_JUMP_MID,
+    P_JUMP_PEAK,
+    P_FALL,
+    P_ALERT,
+    P_LAND,
+    P_CROUCH,
+    P_HURT,
+    P_KNOCKDOWN,
+    P_VICTORY,
+    P_DEATH_FADE,
+    P_POWER_RUN,
+    P_JETPACK,
+    P_SHOOT,
+    P_SHOOT_FORWARD,
+    P_SHOOT_SIDE
+};
+
+// ============================================================================
+// INPUT SOURCES
+// ============================================================================
+// The game samples keys from an InputSource once per tick into an InputState,
+// so the same simulation can be driven by the real keyboard or by a scripted
+// key timeline (headless runs).
+class InputSource
+{
+public:
+    virtual ~InputSource() {}
+    virtual bool isDown(Keyboard::Key key) const = 0;
+    // Called once before every fixed simulation step
+    virtual void advance() {}
+};
+
+class KeyboardInput : public InputSource
+{
+public:
+    bool isDown(Keyboard::Key key) const { return Keyboard::isKeyPressed(key); }
+};
+
+// Replays a text script of "<tick> <key> <0|1>" lines ('#' starts a comment).
+// A key stays down from its press line until its release line.
+class ScriptedInput : public InputSource
+{
+public:
+    ScriptedInput() : tick(0), cursor(0) { rewind(); }
+
+    bool loadFromFile(const std::string &path)
+    {
+        std::ifstream in(path.c_str());
+        if (!in)
+            return false;
+        events.clear();
+        std::string line;
+        while (std::getline(in, line))
+        {
+            size_t hash = line.find('#');
+            if (hash != std::string::npos)
+                line = line.substr(0, hash);
+            std::istringstream ss(line);
+            ScriptEvent ev;
+            std::string name;
+            int state = 0;
+            if (!(ss >> ev.tick >> name >> state))
+                continue;
+            ev.key = keyFromName(name);
+            if (ev.key == Keyboard::Unknown)
+            {
+                cout << "[WARN] Unknown key in input script: " << name << endl;
+                continue;
+            }
+            ev.down = state != 0;
+            events.push_back(ev);
+        }
+        std::stable_sort(events.begin(), events.end(),
+                         [](const ScriptEvent &a, const ScriptEvent &b)
+                         { return a.tick < b.tick; });
+        rewind();
+        return true;
+    }
+
+    bool isDown(Keyboard::Key key) const
+    {
+        return key >= 0 && key < Keyboard::KeyCount && down[key];
+    }
+
+    void advance()
+    {
+        while (cursor < events.size() && events[cursor].tick <= tick)
+        {
+            down[events[cursor].key] = events[cursor].down;
+            cursor++;
+        }
+        tick++;
+    }
+
+    void rewind()
+    {
+        tick = 0;
+        cursor = 0;
+        for (int i = 0; i < Keyboard::KeyCount; i++)
+            down[i] = false;
+    }
+
+    bool finished() const { return cursor >= events.size(); }
+
+    static Keyboard::Key keyFromName(const std::string &name)
+    {
+        static const struct
+        {
+            const char *name;
+            Keyboard::Key key;
+        } table[] = {
+            {"Left", Keyboard::Left}, {"Right", Keyboard::Right}, {"Up", Keyboard::Up},
+            {"Down", Keyboard::Down}, {"W", Keyboard::W}, {"A", Keyboard::A},
+            {"S", Keyboard::S}, {"D", Keyboard::D}, {"Space", Keyboard::Space},
+            {"Z", Keyboard::Z}, {"X", Keyboard::X}, {"Enter", Keyboard::Enter},
+            {"R", Keyboard::R}, {"Escape", Keyboard::Escape}, {"Num1", Keyboard::Num1},
+            {"Num2", Keyboard::Num2}};
+        for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++)
+        {
+            if (name == table[i].name)
+                return table[i].key;
+        }
+        return Keyboard::Unknown;
+    }
+
+private:
+    struct ScriptEvent
+    {
+        int tick;
+        Keyboard::Key key;
+        bool down;
+    };
+
+    std::vector<ScriptEvent> events;
+    int tick;
+    size_t cursor;
+    bool down[Keyboard::KeyCount];
+};
+
+// Snapshot of every game action for one simulation tick. capture() is called
+// once per fixed step; pressed() is true only on the tick a key goes down,
+// which replaces the old per-function "static bool wasPressed" bookkeeping.
+class InputState
+{
+public:
+    enum Action
+    {
+        MOVE_LEFT = 0,
+        MOVE_RIGHT,
+        JUMP,
+        DROP,
+        AIM_UP,
+        AIM_LEFT,
+        AIM_DOWN,
+        AIM_RIGHT,
+        VACUUM,
+        SHOOT,
+        BURST,
+        RESTART,
+        SELECT_YELLOW,
+        SELECT_GREEN,
+        CONFIRM,
+        QUIT,
+        ACTION_COUNT
+    };
+
+    InputState() : current(0), previous(0) {}
+
+    void capture(const InputSource &source)
+    {
+        previous = current;
+        current = 0;
+        for (int a = 0; a < ACTION_COUNT; a++)
+        {
+            if (source.isDown(keyFor((Action)a)))
+                current |= 1u << a;
+        }
+    }
+
+    // Forget held keys so the next capture reports fresh presses
+    void clear()
+    {
+        current = 0;
+        previous = 0;
+    }
+
+    // Replays a recorded snapshot as this tick's input
+    void apply(unsigned int bits)
+    {
+        previous = current;
+        current = bits;
+    }
+
+    unsigned int bits() const { return current; }
+
+    bool down(Action a) const { return (current >> a) & 1u; }
+    bool pressed(Action a) const { return down(a) && !((previous >> a) & 1u); }
+
+    // True when any of W/A/S/D is held (explicit vacuum aim)
+    bool aiming() const
+    {
+        return down(AIM_UP) || down(AIM_LEFT) || down(AIM_DOWN) || down(AIM_RIGHT);
+    }
+
+    static Keyboard::Key keyFor(Action a)
+    {
+        static const Keyboard::Key keys[ACTION_COUNT] = {
+            Keyboard::Left, Keyboard::Right, Keyboard::Up, Keyboard::Down,
+            Keyboard::W, Keyboard::A, Keyboard::S, Keyboard::D,
+            Keyboard::Space, Keyboard::Z, Keyboard::X, Keyboard::R,
+            Keyboard::Num1, Keyboard::Num2, Keyboard::Enter, Keyboard::Escape};
+        return keys[a];
+    }
+
+private:
+    unsigned int current;
+    unsigned int previous;
+};
+
+// Per-tick InputState snapshots plus what else a session depends on (RNG seed,
+// character). Ticks are stored run-length encoded as (action mask, run length)
+// pairs of 16-bit values, so held keys and idle stretches cost almost nothing.
+//   "TPRP" | u8 version | u8 character | u64 seed | u32 ticks | u32 runs | runs
+class InputReplay
+{
+public:
+    InputReplay() : seed(0), character(0), ticks(0), cursor(0), runTick(0) {}
+
+    uint64_t seed;
+    int character;
+
+    void reset(uint64_t rngSeed)
+    {
+        seed = rngSeed;
+        character = 0;
+        ticks = 0;
+        runs.clear();
+        rewind();
+    }
+
+    void record(unsigned int bits)
+    {
+        uint16_t mask = (uint16_t)bits;
+        if (runs.empty() || runs.back().mask != mask || runs.back().length == 0xFFFF)
+            runs.push_back(Run{mask, 0});
+        runs.back().length++;
+        ticks++;
+    }
+
+    // Input for the next tick; all keys up once the recording is exhausted
+    unsigned int next()
+    {
+        if (cursor >= runs.size())
+            return 0;
+        unsigned int bits = runs[cursor].mask;
+        if (++runTick >= runs[cursor].length)
+        {
+            cursor++;
+            runTick = 0;
+        }
+        return bits;
+    }
+
+    void rewind()
+    {
+        cursor = 0;
+        runTick = 0;
+    }
+
+    bool finished() const { return cursor >= runs.size(); }
+    uint32_t tickCount() const { return ticks; }
+
+    bool save(const std::string &path) const
+    {
+        std::ofstream out(path.c_str(), std::ios::binary);
+        if (!out)
+            return false;
+        out.write("TPRP", 4);
+        put(out, VERSION, 1);
+        put(out, (uint64_t)character, 1);
+        put(out, seed, 8);
+        put(out, ticks, 4);
+        put(out, runs.size(), 4);
+        for (size_t i = 0; i < runs.size(); i++)
+        {
+            put(out, runs[i].mask, 2);
+            put(out, runs[i].length, 2);
+        }
+        return (bool)out;
+    }
+
+    bool load(const std::string &path)
+    {
+        std::ifstream in(path.c_str(), std::ios::binary);
+        char magic[4];
+        if (!in.read(magic, 4) || std::string(magic, 4) != "TPRP" || get(in, 1) != VERSION)
+            return false;
+        character = (int)get(in, 1);
+        seed = get(in, 8);
+        ticks = (uint32_t)get(in, 4);
+        uint32_t count = (uint32_t)get(in, 4);
+        runs.clear();
+        runs.reserve(count);
+        for (uint32_t i = 0; i < count && in; i++)
+        {
+            Run r;
+            r.mask = (uint16_t)get(in, 2);
+            r.length = (uint16_t)get(in, 2);
+            runs.push_back(r);
+        }
+        rewind();
+        return (bool)in;
+    }
+
+private:
+    static const uint64_t VERSION = 1;
+
+    struct Run
+    {
+        uint16_t mask;
+        uint16_t length;
+    };
+
+    // Little-endian fixed-width fields
+    static void put(std::ofstream &out, uint64_t v, int bytes)
+    {
+        for (int i = 0; i < bytes; i++)
+            out.put((char)((v >> (8 * i)) & 0xFF));
+    }
+
+    static uint64_t get(std::ifstream &in, int bytes)
+    {
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; i++)
+            v |= (uint64_t)(unsigned char)in.get() << (8 * i);
+        return v;
+    }
+
+    std::vector<Run> runs;
+    uint32_t ticks;
+    size_t cursor;
+    uint16_t runTick;
+};
+
+// ============================================================================
+// TEXTURE CACHE
+// ============================================================================
+// Path-keyed texture store. Every Game texture member is a reference into one of
+// these slots, so members that name the same file (8.png backs the vacuum beam,
+// the rainbow shot and the stars) share a single decode and a single GPU upload.
+// Slots live in a std::map so references stay valid as more paths are added.
+// acquire() counts holders; when release() drops the last one the pixels are
+// freed but the (empty) slot stays, and a later load() brings them back. Game
+// members hold their slot for the whole run; per-level sheets (the level 2
+// backdrop) are acquired by startLevel() and released when a level stops
+// needing them. A fallback file may only be loaded into a slot nobody else
+// shares.
+// An offline cache (headless runs) decodes files only to learn their size and
+// never creates GPU textures; sheetSize() reports those sizes to gameplay code.
+// startDecode() can decode a batch of files into CPU images on worker threads;
+// load() then only has to upload the already-decoded pixels.
+static std::map<const Texture *, Vector2u> offlineSheetSizes;
+
+// Size of a sprite sheet, valid for both uploaded and offline textures
+static Vector2u sheetSize(const Texture &tex)
+{
+    if (!offlineSheetSizes.empty())
+    {
+        std::map<const Texture *, Vector2u>::const_iterator it = offlineSheetSizes.find(&tex);
+        if (it != offlineSheetSizes.end())
+            return it->second;
+    }
+    return tex.getSize();
+}
+
+class TextureCache
+{
+public:
+    TextureCache() : decodeCount(0), evictions(0), offline(false), nextJob(0), jobsDone(0) {}
+
+    ~TextureCache() { finishDecode(); }
+
+    // Returns the slot for path and takes a reference to it
+    Texture &acquire(const std::string &path)
+    {
+        Entry &e = entries[path];
+        e.refs++;
+        return e.tex;
+    }
+
+    // Returns the slot for path without taking a reference, for members bound
+    // to a texture that is only acquired while a level needs it
+    Texture &slot(const std::string &path) { return entries[path].tex; }
+
+    // Drops one reference; the pixels are freed once nobody holds the slot
+    void release(const std::string &path)
+    {
+        std::map<std::string, Entry>::iterator it = entries.find(path);
+        if (it == entries.end() || it->second.refs <= 0)
+            return;
+        if (--it->second.refs == 0)
+        {
+            offlineSheetSizes.erase(&it->second.tex);
+            it->second.tex = Texture();
+            it->second.loaded = false;
+            it->second.tried.clear();
+            evictions++;
+        }
+    }
+
+    // Loads file into the slot keyed by path (file defaults to path itself, a
+    // different file acts as a fallback source). Already-loaded slots and files
+    // that already failed for this slot return immediately without decoding.
+    bool load(const std::string &path, const std::string &file = "")
+    {
+        Entry &e = entries[path];
+        if (e.loaded)
+            return true;
+        const std::string &src = file.empty() ? path : file;
+        for (size_t i = 0; i < e.tried.size(); i++)
+        {
+            if (e.tried[i] == src)
+                return false;
+        }
+        e.tried.push_back(src);
+
+        std::map<std::string, int>::iterator pre = decodeIndex.find(src);
+        if (pre != decodeIndex.end())
+        {
+            // Decoded by a worker already; upload and drop the CPU copy
+            int idx = pre->second;
+            if (offline)
+            {
+                e.loaded = decodeOk[idx] != 0;
+                if (e.loaded)
+                    offlineSheetSizes[&e.tex] = decodeImages[idx].getSize();
+            }
+            else
+            {
+                e.loaded = decodeOk[idx] && e.tex.loadFromImage(decodeImages[idx]);
+            }
+            decodeImages[idx] = Image();
+            decodeIndex.erase(pre);
+            return e.loaded;
+        }
+
+        decodeCount++;
+        if (offline)
+        {
+            Image img;
+            e.loaded = img.loadFromFile(src);
+            if (e.loaded)
+                offlineSheetSizes[&e.tex] = img.getSize();
+            return e.loaded;
+        }
+        e.loaded = e.tex.loadFromFile(src);
+        return e.loaded;
+    }
+
+    void setOffline(bool on) { offline = on; }
+
+    // Paths of every slot that has been acquired but not loaded yet
+    std::vector<std::string> pendingPaths() const
+    {
+        std::vector<std::string> out;
+        for (std::map<std::string, Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+        {
+            if (it->second.refs > 0 && !it->second.loaded && it->second.tried.empty())
+                out.push_back(it->first);
+        }
+        return out;
+    }
+
+    // Start decoding files on a small worker pool; poll decodeProgress() from the
+    // main thread and call finishDecode() before the next load()
+    void startDecode(const std::vector<std::string> &files)
+    {
+        finishDecode();
+        decodeFiles = files;
+        decodeImages.assign(files.size(), Image());
+        decodeOk.assign(files.size(), 0);
+        decodeIndex.clear();
+        for (size_t i = 0; i < files.size(); i++)
+            decodeIndex[files[i]] = (int)i;
+        nextJob = 0;
+        jobsDone = 0;
+        decodeCount += (int)files.size();
+
+        int threads = std::min(DECODE_THREADS, (int)files.size());
+        for (int i = 0; i < threads; i++)
+        {
+            workers.push_back(new Thread(&TextureCache::decodeWorker, this));
+            workers.back()->launch();
+        }
+    }
+
+    float decodeProgress() const
+    {
+        if (decodeFiles.empty())
+            return 1.0f;
+        return (float)jobsDone / (float)decodeFiles.size();
+    }
+
+    bool decodeFinished() const { return jobsDone >= (int)decodeFiles.size(); }
+
+    void finishDecode()
+    {
+        for (size_t i = 0; i < workers.size(); i++)
+        {
+            workers[i]->wait();
+            delete workers[i];
+        }
+        workers.clear();
+    }
+
+    int slotCount() const { return (int)entries.size(); }
+    int getDecodeCount() const { return decodeCount; }
+    int getEvictionCount() const { return evictions; }
+
+    // Slots with at least one holder and uploaded pixels
+    int residentCount() const
+    {
+        int n = 0;
+        for (std::map<std::string, Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+            if (it->second.refs > 0 && it->second.loaded)
+                n++;
+        return n;
+    }
+
+private:
+    struct Entry
+    {
+        Texture tex;
+        int refs = 0;
+        bool loaded = false;
+        std::vector<std::string> tried;
+    };
+
+    static const int DECODE_THREADS = 4;
+
+    // Each worker claims the next file index until the list runs out; images are
+    // pre-sized so workers never touch shared containers
+    void decodeWorker()
+    {
+        for (;;)
+        {
+            int idx = nextJob++;
+            if (idx >= (int)decodeFiles.size())
+                break;
+            decodeOk[idx] = decodeImages[idx].loadFromFile(decodeFiles[idx]) ? 1 : 0;
+            jobsDone++;
+        }
+    }
+
+    std::map<std::string, Entry> entries;
+    int decodeCount;
+    int evictions;
+    bool offline;
+
+    std::vector<std::string> decodeFiles;
+    std::vector<Image> decodeImages;
+    std::vector<char> decodeOk;
+    std::map<std::string, int> decodeIndex;
+    std::vector<Thread *> workers;
+    std::atomic<int> nextJob;
+    std::atomic<int> jobsDone;
+};
+
+// ============================================================================
+// TEXTURE ATLAS
+// ============================================================================
+// Packs many small sprite sheets into a few large pages at load time so sprites
+// from different systems (HUD, enemies, effects) end up on the same texture.
+// Rects stay in sheet space everywhere in gameplay code; remap() translates a
+// sheet-space rect into its page at draw time.
+class TextureAtlas
+{
+public:
+    struct Region
+    {
+        int page;
+        Vector2i offset;
+        Vector2u size;
+    };
+
+    TextureAtlas() : pageSize(0) {}
+
+    void clear()
+    {
+        pending.clear();
+        regions.clear();
+        pages.clear();
+    }
+
+    // Queue a loaded sheet for packing; empty or oversized sheets are skipped
+    // and keep drawing from their own texture
+    void add(const Texture &source)
+    {
+        if (source.getSize().x == 0 || source.getSize().y == 0 || regions.count(&source))
+            return;
+        for (size_t i = 0; i < pending.size(); i++)
+        {
+            if (pending[i].source == &source)
+                return;
+        }
+        Pending p;
+        p.source = &source;
+        p.pixels = source.copyToImage();
+        pending.push_back(p);
+    }
+
+    // Shelf-pack every queued sheet (tallest first) and upload the pages
+    void build()
+    {
+        pageSize = std::min(Texture::getMaximumSize(), 4096u);
+        std::stable_sort(pending.begin(), pending.end(),
+                         [](const Pending &a, const Pending &b)
+                         { return a.pixels.getSize().y > b.pixels.getSize().y; });
+
+        std::vector<Image> pageImages;
+        unsigned int shelfX = 0, shelfY = 0, shelfH = 0;
+        for (size_t i = 0; i < pending.size(); i++)
+        {
+            Vector2u sz = pending[i].pixels.getSize();
+            if (sz.x + PADDING > pageSize || sz.y + PADDING > pageSize)
+                continue;
+            if (pageImages.empty())
+            {
+                pageImages.push_back(Image());
+                pageImages.back().create(pageSize, pageSize, Color::Transparent);
+                shelfX = shelfY = shelfH = 0;
+            }
+            if (shelfX + sz.x + PADDING > pageSize)
+            {
+                shelfX = 0;
+                shelfY += shelfH;
+                shelfH = 0;
+            }
+            if (shelfY + sz.y + PADDING > pageSize)
+            {
+                pageImages.push_back(Image());
+                pageImages.back().create(pageSize, pageSize, Color::Transparent);
+                shelfX = shelfY = shelfH = 0;
+            }
+
+            Region r;
+            r.page = (int)pageImages.size() - 1;
+            r.offset = Vector2i((int)shelfX, (int)shelfY);
+            r.size = sz;
+            pageImages.back().copy(pending[i].pixels, shelfX, shelfY);
+            regions[pending[i].source] = r;
+
+            shelfX += sz.x + PADDING;
+            shelfH = std::max(shelfH, sz.y + PADDING);
+        }
+        pending.clear();
+
+        for (size_t i = 0; i < pageImages.size(); i++)
+        {
+            pages.push_back(Texture());
+            pages.back().loadFromImage(pageImages[i]);
+        }
+    }
+
+    // Translate a sheet-space rect into atlas space. Rects that reach outside
+    // their sheet are left alone so edge sampling matches the original texture.
+    bool remap(const Texture *source, const Texture *&page, IntRect &rect) const
+    {
+        std::map<const Texture *, Region>::const_iterator it = regions.find(source);
+        if (it == regions.end())
+            return false;
+        const Region &r = it->second;
+        int x0 = std::min(rect.left, rect.left + rect.width);
+        int x1 = std::max(rect.left, rect.left + rect.width);
+        int y0 = std::min(rect.top, rect.top + rect.height);
+        int y1 = std::max(rect.top, rect.top + rect.height);
+        if (x0 < 0 || y0 < 0 || x1 > (int)r.size.x || y1 > (int)r.size.y)
+            return false;
+        page = &pages[r.page];
+        rect.left += r.offset.x;
+        rect.top += r.offset.y;
+        return true;
+    }
+
+    int pageCount() const { return (int)pages.size(); }
+    int regionCount() const { return (int)regions.size(); }
+
+private:
+    static const unsigned int PADDING = 2;
+
+    struct Pending
+    {
+        const Texture *source;
+        Image pixels;
+    };
+
+    unsigned int pageSize;
+    std::vector<Pending> pending;
+    std::map<const Texture *, Region> regions;
+    std::deque<Texture> pages;
+};
+
+// ============================================================================
+// SPRITE BATCH
+// ============================================================================
+// Collects sprite quads per layer and per texture while a frame is being built,
+// then flushes each (layer, texture) bucket with a single draw call. With the
+// atlas in place nearly every gameplay sprite lands in the same bucket, so the
+// number of draw calls stays flat no matter how many entities are alive.
+class SpriteBatch
+{
+public:
+    enum Layer
+    {
+        LAYER_POWERUPS = 0,
+        LAYER_ENEMIES,
+        LAYER_ENEMY_SHOTS,
+        LAYER_PROJECTILES,
+        LAYER_PLAYER,
+        LAYER_HUD,
+        LAYER_EFFECTS,
+        LAYER_COUNT
+    };
+
+    SpriteBatch() : open(false), layer(0), drawCalls(0), quads(0), lastDrawCalls(0), lastQuads(0), hasWorldView(false) {}
+
+    void begin()
+    {
+        open = true;
+        layer = 0;
+        hasWorldView = false;
+    }
+
+    // Draw every layer but LAYER_HUD through view; without it, layers use
+    // whatever view the target has (menus)
+    void setWorldView(const View &view)
+    {
+        worldView = view;
+        hasWorldView = true;
+    }
+
+    bool isOpen() const { return open; }
+
+    void setLayer(int l)
+    {
+        if (l >= 0 && l < LAYER_COUNT)
+            layer = l;
+    }
+
+    int getLayer() const { return layer; }
+
+    static const char *name(int l)
+    {
+        static const char *names[LAYER_COUNT] = {
+            "powerups", "enemies", "enemy_shots", "projectiles", "player", "hud", "effects"};
+        return names[l];
+    }
+
+    // Queue one textured quad; rect is in the coordinate space of tex
+    void add(const Texture *tex, const IntRect &rect, const Transform &transform, const Color &color)
+    {
+        VertexArray &verts = bucketFor(tex);
+        float w = (float)std::abs(rect.width);
+        float h = (float)std::abs(rect.height);
+        float left = (float)rect.left;
+        float right = left + rect.width;
+        float top = (float)rect.top;
+        float bottom = top + rect.height;
+
+        verts.append(Vertex(transform.transformPoint(0, 0), color, Vector2f(left, top)));
+        verts.append(Vertex(transform.transformPoint(w, 0), color, Vector2f(right, top)));
+        verts.append(Vertex(transform.transformPoint(w, h), color, Vector2f(right, bottom)));
+        verts.append(Vertex(transform.transformPoint(0, h), color, Vector2f(left, bottom)));
+    }
+
+    // Draw everything queued so far in layer order; the batch stays open so
+    // callers can interleave non-sprite draws (e.g. TTF text) and keep going
+    void flush(RenderTarget &target)
+    {
+        View saved = target.getView();
+        for (int l = 0; l < LAYER_COUNT; l++)
+        {
+            std::vector<Bucket> &buckets = layers[l];
+            if (hasWorldView)
+                target.setView(l == LAYER_HUD ? target.getDefaultView() : worldView);
+            for (size_t i = 0; i < buckets.size(); i++)
+            {
+                if (buckets[i].verts.getVertexCount() == 0)
+                    continue;
+                target.draw(buckets[i].verts, RenderStates(buckets[i].tex));
+                drawCalls++;
+                quads += (int)buckets[i].verts.getVertexCount() / 4;
+                buckets[i].verts.clear();
+            }
+        }
+        target.setView(saved);
+    }
+
+    void end(RenderTarget &target)
+    {
+        flush(target);
+        open = false;
+        lastDrawCalls = drawCalls;
+        lastQuads = quads;
+        drawCalls = 0;
+        quads = 0;
+    }
+
+    int getLastDrawCalls() const { return lastDrawCalls; }
+    int getLastQuads() const { return lastQuads; }
+
+private:
+    struct Bucket
+    {
+        const Texture *tex;
+        VertexArray verts;
+    };
+
+    VertexArray &bucketFor(const Texture *tex)
+    {
+        std::vector<Bucket> &buckets = layers[layer];
+        for (size_t i = 0; i < buckets.size(); i++)
+        {
+            if (buckets[i].tex == tex)
+                return buckets[i].verts;
+        }
+        Bucket b;
+        b.tex = tex;
+        b.verts.setPrimitiveType(Quads);
+        buckets.push_back(b);
+        return buckets.back().verts;
+    }
+
+    bool open;
+    int layer;
+    int drawCalls;
+    int quads;
+    int lastDrawCalls;
+    int lastQuads;
+    bool hasWorldView;
+    View worldView;
+    std::vector<Bucket> layers[LAYER_COUNT];
+};
+
+// ============================================================================
+// MUSIC STREAMER
+// ============================================================================
+// Two-deck music player. prefetch() opens the next track on a background thread
+// while the current one keeps playing, so play() at a level transition only has
+// to start an already-open stream and crossfade it over the old one. A prefetch
+// that arrives while the idle deck is still fading out waits until the fade ends.
+class MusicStreamer
+{
+public:
+    MusicStreamer()
+        : worker(&MusicStreamer::prefetchWorker, this), active(-1), fading(-1),
+          fadeTimer(0), fadeTime(0), volume(100.0f), prefetchDeck(-1), prefetchOk(false), enabled(false) {}
+
+    ~MusicStreamer()
+    {
+        worker.wait();
+    }
+
+    void setVolume(float v) { volume = v; }
+
+    // Creates the decks. Until then (and for good in headless runs) the streamer
+    // owns no sf::Music, so nothing opens the audio device, and every call is a
+    // no-op.
+    void enable()
+    {
+        if (enabled)
+            return;
+        decks[0].reset(new Music());
+        decks[1].reset(new Music());
+        enabled = true;
+    }
+
+    // Open path on the idle deck in the background; no-op if it is already
+    // queued or already open on the active deck. A prefetch that failed is
+    // tried again.
+    void prefetch(const std::string &path)
+    {
+        if (!enabled)
+            return;
+        worker.wait();
+        if ((prefetchDeck >= 0 && prefetchPath == path && prefetchOk) || queuedPath == path)
+            return;
+        if (active >= 0 && deckPath[active] == path)
+            return;
+        prefetchDeck = -1;
+        queuedPath = path;
+        if (fading < 0)
+            startQueued();
+    }
+
+    // Switch to path, crossfading from whatever is playing. Reuses the active
+    // deck when it already holds path, and falls back to a synchronous open if
+    // the track was not prefetched.
+    void play(const std::string &path, float crossfade = 1.0f)
+    {
+        if (!enabled)
+            return;
+        worker.wait();
+        if (active >= 0 && deckPath[active] == path)
+        {
+            if (fading >= 0)
+                endFade();
+            if (decks[active]->getStatus() != SoundSource::Playing)
+            {
+                decks[active]->setVolume(volume);
+                decks[active]->play();
+            }
+            startQueued();
+            return;
+        }
+
+        int deck;
+        if (prefetchDeck >= 0 && prefetchPath == path && prefetchOk)
+        {
+            deck = prefetchDeck;
+        }
+        else
+        {
+            if (queuedPath == path)
+                queuedPath.clear();
+            deck = (active == 0) ? 1 : 0;
+            if (deck == fading)
+                endFade();
+            decks[deck]->stop();
+            deckPath[deck].clear();
+            if (!decks[deck]->openFromFile(path))
+            {
+                prefetchDeck = -1;
+                return;
+            }
+            deckPath[deck] = path;
+        }
+        prefetchDeck = -1;
+
+        if (fading >= 0)
+            endFade();
+        bool fadeIn = active >= 0 && decks[active]->getStatus() == SoundSource::Playing && crossfade > 0;
+        decks[deck]->setLoop(true);
+        decks[deck]->setVolume(fadeIn ? 0.0f : volume);
+        decks[deck]->play();
+        if (fadeIn)
+        {
+            fading = active;
+            fadeTimer = 0;
+            fadeTime = crossfade;
+        }
+        else if (active >= 0)
+        {
+            decks[active]->stop();
+        }
+        active = deck;
+        if (fading < 0)
+            startQueued();
+    }
+
+    void update(float dt)
+    {
+        if (!enabled || fading < 0)
+            return;
+        fadeTimer += dt;
+        float t = std::min(1.0f, fadeTimer / fadeTime);
+        decks[active]->setVolume(volume * t);
+        decks[fading]->setVolume(volume * (1.0f - t));
+        if (t >= 1.0f)
+        {
+            endFade();
+            startQueued();
+        }
+    }
+
+    void stop()
+    {
+        if (!enabled)
+            return;
+        if (fading >= 0)
+            endFade();
+        if (active >= 0)
+            decks[active]->stop();
+        startQueued();
+    }
+
+private:
+    void prefetchWorker()
+    {
+        prefetchOk = decks[prefetchDeck]->openFromFile(prefetchPath);
+        if (!prefetchOk)
+            deckPath[prefetchDeck].clear();
+    }
+
+    // Launch the waiting prefetch on the idle deck; callers make sure that deck
+    // is no longer fading out. A deck that still holds the track is reused.
+    void startQueued()
+    {
+        if (queuedPath.empty())
+            return;
+        worker.wait();
+        int deck = (active == 0) ? 1 : 0;
+        decks[deck]->stop();
+        prefetchDeck = deck;
+        prefetchPath = queuedPath;
+        queuedPath.clear();
+        if (deckPath[deck] == prefetchPath)
+        {
+            prefetchOk = true;
+            return;
+        }
+        deckPath[deck] = prefetchPath;
+        prefetchOk = false;
+        worker.launch();
+    }
+
+    void endFade()
+    {
+        decks[fading]->stop();
+        fading = -1;
+        if (active >= 0)
+            decks[active]->setVolume(volume);
+    }
+
+    std::unique_ptr<Music> decks[2];
+    std::string deckPath[2];
+    Thread worker;
+    int active;
+    int fading;
+    float fadeTimer;
+    float fadeTime;
+    float volume;
+    int prefetchDeck;
+    std::string prefetchPath;
+    std::string queuedPath;
+    bool prefetchOk;
+    bool enabled;
+};
+
+// ============================================================================
+// RENDER INTERPOLATION
+// ============================================================================
+// Sprite position at the start and end of the last fixed step. The renderer
+// draws at prev + (cur - prev) * alpha, expressed as an offset from wherever the
+// sprite sits when drawn so draw-time tweaks (row 11 lift) still apply.
+struct RenderLerp
+{
+    Vector2f prev;
+    Vector2f cur;
+    bool valid = false;
+
+    void beginStep(const Sprite &s)
+    {
+        prev = s.getPosition();
+        valid = true;
+    }
+
+    void endStep(const Sprite &s)
+    {
+        cur = s.getPosition();
+        if (!valid)
+        {
+            // Spawned during this step: nothing to blend from
+            prev = cur;
+            valid = true;
+        }
+    }
+
+    Vector2f offset(float alpha) const
+    {
+        return (prev - cur) * (1.0f - alpha);
+    }
+};
+
+// ============================================================================
+// PARTICLE SYSTEM
+// ============================================================================
+// Particles are stored as parallel arrays so the per-tick integration is a set
+// of straight loops over floats. Dead particles are swap-removed (draw order is
+// not meaningful for them) and the whole system is drawn as one vertex array.
+class ParticleSystem
+{
+public:
+    ParticleSystem() : vertices(Quads) { reserve(PARTICLE_POOL); }
+
+    void reserve(size_t n)
+    {
+        px.reserve(n);
+        py.reserve(n);
+        vx.reserve(n);
+        vy.reserve(n);
+        life.reserve(n);
+        maxLife.reserve(n);
+        size.reserve(n);
+        color.reserve(n);
+    }
+
+    void add(Vector2f pos, Vector2f vel, Color col, float lifetime, float sz = 3.0f)
+    {
+        px.push_back(pos.x);
+        py.push_back(pos.y);
+        vx.push_back(vel.x);
+        vy.push_back(vel.y);
+        life.push_back(lifetime);
+        maxLife.push_back(lifetime);
+        size.push_back(sz);
+        color.push_back(col);
+    }
+
+    void emit(Vector2f position, Color color, int count = 10)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            float angle = rngFx.below(360) * 3.14159f / 180.0f;
+            float speed = 2.0f + rngFx.below(100) / 50.0f;
+            Vector2f vel(cos(angle) * speed, sin(angle) * speed);
+            add(position, vel, color, 0.5f + rngFx.below(50) / 100.0f);
+        }
+    }
+
+    void update(float dt)
+    {
+        const size_t n = px.size();
+        const float step = dt * 60.0f;
+        const float fall = GRAVITY * 0.3f;
+        float *x = px.data(), *y = py.data(), *dx = vx.data(), *dy = vy.data(), *t = life.data();
+
+        // Branch-free so the compiler can vectorize each loop
+        for (size_t i = 0; i < n; i++)
+            x[i] += dx[i] * step;
+        for (size_t i = 0; i < n; i++)
+        {
+            y[i] += dy[i] * step;
+            dy[i] += fall;
+        }
+        for (size_t i = 0; i < n; i++)
+            t[i] -= dt;
+
+        for (size_t i = 0; i < px.size();)
+        {
+            if (life[i] <= 0)
+                removeAt(i);
+            else
+                i++;
+        }
+    }
+
+    void draw(RenderTarget &target)
+    {
+        const size_t n = px.size();
+        if (n == 0)
+            return;
+        if (dot.getSize().x == 0)
+            buildDot();
+        const float t = (float)DOT_SIZE;
+        vertices.resize(n * 4);
+        for (size_t i = 0; i < n; i++)
+        {
+            // Same footprint the old per-particle CircleShape(size) covered; the
+            // dot texture keeps the quad round
+            float d = size[i] * 2.0f;
+            Color c = color[i];
+            c.a = (Uint8)((life[i] / maxLife[i]) * 255);
+            Vertex *q = &vertices[i * 4];
+            q[0].position = Vector2f(px[i], py[i]);
+            q[1].position = Vector2f(px[i] + d, py[i]);
+            q[2].position = Vector2f(px[i] + d, py[i] + d);
+            q[3].position = Vector2f(px[i], py[i] + d);
+            q[0].texCoords = Vector2f(0, 0);
+            q[1].texCoords = Vector2f(t, 0);
+            q[2].texCoords = Vector2f(t, t);
+            q[3].texCoords = Vector2f(0, t);
+            q[0].color = q[1].color = q[2].color = q[3].color = c;
+        }
+        target.draw(vertices, &dot);
+    }
+
+    size_t count() const { return px.size(); }
+
+    void clear()
+    {
+        px.clear();
+        py.clear();
+        vx.clear();
+        vy.clear();
+        life.clear();
+        maxLife.clear();
+        size.clear();
+        color.clear();
+    }
+
+private:
+    static const int DOT_SIZE = 32;
+
+    // White disc with a one-pixel soft edge, tinted per vertex. Built on first
+    // draw so headless runs never create a GPU texture.
+    void buildDot()
+    {
+        Image img;
+        img.create(DOT_SIZE, DOT_SIZE, Color::Transparent);
+        const float r = DOT_SIZE * 0.5f;
+        for (int y = 0; y < DOT_SIZE; y++)
+            for (int x = 0; x < DOT_SIZE; x++)
+            {
+                float dx = x + 0.5f - r, dy = y + 0.5f - r;
+                float a = std::max(0.0f, std::min(1.0f, r - std::sqrt(dx * dx + dy * dy)));
+                img.setPixel(x, y, Color(255, 255, 255, (Uint8)(a * 255)));
+            }
+        dot.loadFromImage(img);
+        dot.setSmooth(true);
+    }
+
+    void removeAt(size_t i)
+    {
+        size_t last = px.size() - 1;
+        px[i] = px[last];
+        py[i] = py[last];
+        vx[i] = vx[last];
+        vy[i] = vy[last];
+        life[i] = life[last];
+        maxLife[i] = maxLife[last];
+        size[i] = size[last];
+        color[i] = color[last];
+        px.pop_back();
+        py.pop_back();
+        vx.pop_back();
+        vy.pop_back();
+        life.pop_back();
+        maxLife.pop_back();
+        size.pop_back();
+        color.pop_back();
+    }
+
+    std::vector<float> px, py, vx, vy, life, maxLife, size;
+    std::vector<Color> color;
+    VertexArray vertices;
+    Texture dot;
+};
+
+// ============================================================================
+// SCORE MANAGER
+// ============================================================================
+class ScoreManager
+{
+public:
+    int score;
+    int combo;
+    float comboTimer;
+    bool noDamage;
+    float levelTime;
+    float scoreAnimTimer; // MASTERCLASS: For animated score pop effect
+
+    ScoreManager() { reset(); }
+
+    void reset()
+    {
+        score = 0;
+        combo = 0;
+        comboTimer = 0;
+        noDamage = true;
+        levelTime = 0;
+        scoreAnimTimer = 0;
+    }
+
+    void resetLevel()
+    {
+        combo = 0;
+        comboTimer = 0;
+        noDamage = true;
+        levelTime = 0;
+        scoreAnimTimer = 0;
+    }
+
+    void update(float dt)
+    {
+        levelTime += dt;
+        if (comboTimer > 0)
+        {
+            comboTimer -= dt;
+            if (comboTimer <= 0)
+            {
+                combo = 0;
+            }
+        }
+        // MASTERCLASS: Update score animation timer
+        if (scoreAnimTimer > 0)
+            scoreAnimTimer -= dt;
+    }
+
+    void addCapturePoints(int points, int currentCapturedCount)
+    {
+        score += points;
+        scoreAnimTimer = 0.3f; // MASTERCLASS: Trigger score pop
+        // CONSOLE OUTPUT (Requirement 3)
+        // "Captured 1" (No max capacity)
+        LOG_INFO("Captured " << currentCapturedCount);
+    }
+
+    void addDefeatPoints(int basePoints)
+    {
+        int points = basePoints * 2;
+        if (combo >= 5)
+        {
+            points = (int)(points * 2.0f);
+        }
+        else if (combo >= 3)
+        {
+            points = (int)(points * 1.5f);
+        }
+        score += points;
+        combo++;
+        comboTimer = 3.0f;
+        scoreAnimTimer = 0.4f; // MASTERCLASS: Trigger score pop
+    }
+
+    void addMultiKillBonus(int count)
+    {
+        int bonus = 0;
+        if (count >= 3)
+            bonus = 500;
+        else if (count == 2)
+            bonus = 200;
+        if (bonus > 0)
+            score += bonus;
+    }
+
+    void addVacuumBurstBonus(int count)
+    {
+        if (count >= 3)
+            score += 300;
+    }
+
+    void addAerialBonus()
+    {
+        score += 150;
+    }
+
+    void addCharacterBonus(const std::string &label)
+    {
+        score += 500;
+        LOG_DEBUG("[CHARACTER BONUS] " << label << " +500 (Total: " << score << ")");
+    }
+
+    void playerHit()
+    {
+        score -= 50;
+        if (score < 0)
+            score = 0;
+        noDamage = false;
+        combo = 0;
+        comboTimer = 0;
+    }
+
+    void playerDeath()
+    {
+        score -= 200;
+        if (score < 0)
+            score = 0;
+    }
+
+    void levelComplete(int level)
+    {
+        if (level == 1)
+        {
+            score += 1000;
+            if (noDamage)
+                score += 1500;
+            if (levelTime < 30)
+                score += 2000;
+            else if (levelTime < 45)
+                score += 1000;
+            else if (levelTime < 60)
+                score += 500;
+        }
+        else
+        {
+            score += 2000;
+            if (noDamage)
+                score += 2500;
+            if (levelTime < 60)
+                score += 3000;
+            else if (levelTime < 90)
+                score += 1500;
+            else if (levelTime < 120)
+                score += 750;
+        }
+    }
+};
+
+// ============================================================================
+// ANIMATION CLIPS
+// ============================================================================
+// Animation label names resolved to integer ids, so per-frame animation code
+// indexes a table instead of hashing strings.
+enum AnimLabel
+{
+    ANIM_IDLE,
+    ANIM_RUN,
+    ANIM_SPIN,
+    ANIM_RECOVER,
+    ANIM_CHASE,
+    ANIM_CHARGE,
+    ANIM_ATTACK,
+    ANIM_CAPTURE,
+    ANIM_HIT,
+    ANIM_WALK,
+    ANIM_JUMP,
+    ANIM_ATTACK_ORB,
+    ANIM_LABEL_COUNT
+};
+
+// Inclusive [first, last] frame ranges for the labels a sheet defines
+struct AnimLabelTable
+{
+    std::pair<int, int> range[ANIM_LABEL_COUNT];
+    unsigned present;
+
+    AnimLabelTable() : present(0) {}
+
+    void clear() { present = 0; }
+    bool empty() const { return present == 0; }
+    bool has(AnimLabel label) const { return (present >> label) & 1u; }
+    const std::pair<int, int> &at(AnimLabel label) const { return range[label]; }
+
+    void set(AnimLabel label, int first, int last)
+    {
+        range[label] = std::make_pair(first, last);
+        present |= 1u << label;
+    }
+
+    bool find(AnimLabel label, int &first, int &last) const
+    {
+        if (!has(label))
+            return false;
+        first = range[label].first;
+        last = range[label].second;
+        return true;
+    }
+};
+
+// Frame tables registered once while loading and shared by every instance that
+// plays them; instances keep a clip id and a frame index. Clips live in a deque
+// so references handed out stay valid as more are registered.
+class AnimClipRegistry
+{
+public:
+    static AnimClipRegistry &shared()
+    {
+        static AnimClipRegistry registry;
+        return registry;
+    }
+
+    // Returns -1 for an empty table so callers fall back to strip slicing
+    int add(const std::vector<IntRect> &frames)
+    {
+        if (frames.empty())
+            return -1;
+        clips.push_back(frames);
+        return (int)clips.size() - 1;
+    }
+
+    const std::vector<IntRect> &frames(int clip) const
+    {
+        static const std::vector<IntRect> none;
+        if (clip < 0 || clip >= (int)clips.size())
+            return none;
+        return clips[clip];
+    }
+
+    int frameCount(int clip) const { return (int)frames(clip).size(); }
+
+    void clear() { clips.clear(); }
+
+private:
+    std::deque<std::vector<IntRect>> clips;
+};
+
+// ============================================================================
+// POWERUP CLASS
+// ============================================================================
+class Powerup
+{
+public:
+    float x, y;
+    PowerupType type;
+    bool active;
+    Sprite sprite;
+    float bobTimer;
+    int animFrames;
+    float animTimer;
+    float animFPS;
+    int frameIndex;
+    int clip;
+    int frameW;
+    int texH;
+
+    Powerup(PowerupType t, float px, float py)
+    {
+        type = t;
+        x = px;
+        y = py;
+        active = true;
+        bobTimer = 0;
+        animFrames = 1;
+        animTimer = 0;
+        animFPS = 8.0f;
+        frameIndex = 0;
+        clip = -1;
+    }
+
+    void setupSprite(Texture &tex)
+    {
+        sprite.setTexture(tex);
+        sprite.setScale(1.5f, 1.5f);
+
+        if (type == POWERUP_SPEED)
+            animFrames = 4;
+        else if (type == POWERUP_POWER)
+            animFrames = 5;
+        else
+            animFrames = max(1u, sheetSize(tex).x / (unsigned)48);
+
+        frameIndex = 0;
+        animTimer = 0;
+
+        frameW = (int)(sheetSize(tex).x / std::max(1, animFrames));
+        texH = (int)sheetSize(tex).y;
+        sprite.setTextureRect(IntRect(0, 0, frameW, texH));
+    }
+
+    void applyClip(int id)
+    {
+        const std::vector<IntRect> &rects = AnimClipRegistry::shared().frames(id);
+        if (!rects.empty())
+        {
+            clip = id;
+            animFrames = (int)rects.size();
+            frameIndex = 0;
+            animTimer = 0;
+            sprite.setTextureRect(rects[0]);
+            frameW = rects[0].width;
+            texH = rects[0].height;
+        }
+    }
+
+    void update(float dt)
+    {
+        if (!active)
+            return;
+
+        bobTimer += dt;
+        float bobOffset = sin(bobTimer * 3.0f) * 5.0f;
+        sprite.setPosition(x - (frameW * 1.5f) / 2.0f, y + bobOffset - (texH * 1.5f) / 2.0f);
+
+        animTimer += dt;
+        if (animFrames > 1 && animTimer > (1.0f / animFPS))
+        {
+            animTimer = 0;
+            frameIndex = (frameIndex + 1) % animFrames;
+            if (clip >= 0)
+            {
+                sprite.setTextureRect(AnimClipRegistry::shared().frames(clip)[frameIndex]);
+            }
+            else
+            {
+                sprite.setTextureRect(IntRect(frameIndex * frameW, 0, frameW, texH));
+            }
+        }
+    }
+
+    bool collidesWith(float px, float py, int pw, int ph)
+    {
+        return (x < px + pw && x + 48 > px && y < py + ph && y + 48 > py);
+    }
+};
+
+// ============================================================================
+// PLAYER CLASS - ENHANCED WITH PROPER ANIMATIONS
+// ============================================================================
+class Player
+{
+public:
+    float x, y;
+    float velocityX, velocityY;
+    int health;
+    bool isYellow;
+    float speed;
+    float baseSpeed;
+    bool onGround;
+    bool facingRight;
+
+    int vacuumDirection;
+    bool vacuumActive;
+    int capturedEnemies[5];
+    int capturedCount;
+    int maxCapacity;
+    float vacuumRange;
+    float baseVacuumRange;
+    float vacuumAngle;
+    float baseVacuumAngle;
+    float vacuumPower;
+
+    // Vacuum Animation State
+    int vacuumAnimState; // 0=OFF, 1=GROW, 2=SUSTAIN, 3=SHRINK
+    float vacuumAnimFrame;
+    float vacuumAnimSpeed;
+    float jumpBoostTimer;
+
+    float speedBoostTimer;
+    float rangeBoostTimer;
+    float powerBoostTimer;
+
+    int animFrame;
+    float animTimer;
+    PlayerAnimState animState;
+    PlayerAnimState prevAnimState;
     float animStateTimer;
     int animFrames;
     int animRow;
@@ -628,6 +2593,7 @@ public:
     bool shootHold;
 
     Sprite sprite;
+    RenderLerp lerp;
 
     // Enhanced animation frame data
     struct AnimSequence
@@ -721,8 +2687,8 @@ public:
     void setupSprite(Texture &tex)
     {
         sprite.setTexture(tex);
-        frameH = (int)tex.getSize().y;
-        int texW = (int)tex.getSize().x;
+        frameH = (int)sheetSize(tex).y;
+        int texW = (int)sheetSize(tex).x;
         int inferred = row1TotalFrames > 0 ? row1TotalFrames : 34;
         frameW = max(1, texW / inferred);
         sprite.setTextureRect(IntRect(0, 0, frameW, frameH));
@@ -747,8 +2713,8 @@ public:
         // Infer dynamic frame size from imp sheets
         if (sheetRow1)
         {
-            frameH = (int)sheetRow1->getSize().y;
-            int texW = (int)sheetRow1->getSize().x;
+            frameH = (int)sheetSize(*sheetRow1).y;
+            int texW = (int)sheetSize(*sheetRow1).x;
             int fwCandidate = (row1TotalFrames > 0) ? texW / row1TotalFrames : PLAYER_FRAME_WIDTH;
             if (fwCandidate > 0 && fwCandidate * row1TotalFrames == texW)
             {
@@ -831,10 +2797,10 @@ public:
         row2Rects.clear();
         auto uniform = [&](Texture *tex, std::vector<IntRect> &out)
         {
-            if (!tex || tex->getSize().x == 0 || tex->getSize().y == 0)
+            if (!tex || sheetSize(*tex).x == 0 || sheetSize(*tex).y == 0)
                 return;
-            int w = (int)tex->getSize().x;
-            int h = (int)tex->getSize().y;
+            int w = (int)sheetSize(*tex).x;
+            int h = (int)sheetSize(*tex).y;
             int fw = PLAYER_FRAME_WIDTH;
             int frames = std::max(1, w / fw);
             out.reserve(frames);
@@ -894,294 +2860,618 @@ public:
         }
         if (rangeBoostTimer > 0)
         {
-            rangeBoostTimer -= dt;
-            if (rangeBoostTimer <= 0)
-                vacuumAngle = baseVacuumAngle;
+            rangeBoostTimer -= dt;
+            if (rangeBoostTimer <= 0)
+                vacuumAngle = baseVacuumAngle;
+        }
+        if (powerBoostTimer > 0)
+        {
+            powerBoostTimer -= dt;
+            if (powerBoostTimer <= 0)
+                vacuumRange = baseVacuumRange;
+        }
+    }
+
+    void captureEnemy(int type)
+    {
+        if (capturedCount < maxCapacity)
+        {
+            capturedEnemies[capturedCount++] = type;
+        }
+    }
+
+    int releaseOneEnemy()
+    {
+        if (capturedCount > 0)
+        {
+            int type = capturedEnemies[--capturedCount];
+            capturedEnemies[capturedCount] = -1;
+            return type;
+        }
+        return -1;
+    }
+
+    void releaseAllEnemies(int *types, int &count)
+    {
+        count = capturedCount;
+        for (int i = 0; i < capturedCount; i++)
+            types[i] = capturedEnemies[capturedCount - 1 - i];
+        capturedCount = 0;
+        for (int i = 0; i < 5; i++)
+            capturedEnemies[i] = -1;
+    }
+
+    void update(float dt, const TileGrid &tiles)
+    {
+        // Decrement powerup timers and restore base speed/range/angle when expired
+        updatePowerups(dt);
+
+        // Physics
+        if (!onGround)
+        {
+            velocityY += GRAVITY;
+            if (velocityY > TERMINAL_VELOCITY)
+                velocityY = TERMINAL_VELOCITY;
+        }
+
+        // Apply horizontal movement scaled by frame time; vertical moves by velocityY
+        x += velocityX * dt * 60.0f;
+        y += velocityY;
+
+        checkCollisions(tiles);
+
+        // Track time spent in current animation state; treat tiny velocities as standing
+        animStateTimer += dt;
+        bool movingHoriz = fabs(velocityX) > 0.1f;
+
+        // Store previous state for transition detection
+        prevAnimState = animState;
+
+        // Gate early exit when in hurt/knockdown/shoot sequences; otherwise evaluate movement
+        if (!(animState == P_HURT && animStateTimer < 0.35f) &&
+            !(animState == P_KNOCKDOWN && animStateTimer < 0.5f) &&
+            !(animState == P_SHOOT && animStateTimer < 0.3f) &&
+            !(animState == P_SHOOT_FORWARD && animStateTimer < 0.3f) &&
+            !(animState == P_SHOOT_SIDE && animStateTimer < 0.3f))
+        {
+
+            if (onGround)
+            {
+                if (!movingHoriz)
+                {
+                    animState = P_IDLE;
+                }
+                else
+                {
+                    animState = (speedBoostTimer > 0) ? P_POWER_RUN : P_RUN;
+                }
+            }
+            else
+            {
+                // Choose jump phase based on vertical velocity thresholds
+                if (velocityY < -9.0f)
+                {
+                    animState = P_JUMP_START;
+                }
+                else if (velocityY < -2.0f)
+                {
+                    animState = P_JUMP_MID;
+                }
+                else if (fabs(velocityY) < 1.8f)
+                {
+                    animState = P_JUMP_PEAK;
+                }
+                else if (velocityY > 0)
+                {
+                    animState = P_FALL;
+                }
+            }
+        }
+
+        // Reset animation frame if state changed
+        if (animState != prevAnimState)
+        {
+            animFrame = 0;
+            animTimer = 0;
+            animStateTimer = 0;
+        }
+
+        // Get current animation sequence
+        AnimSequence &anim = animations[animState];
+        seqSheet = anim.texture;
+        seqStart = anim.startFrame;
+        animFrames = anim.frameCount;
+        animFPS = anim.fps;
+
+        // Update animation frame
+        animTimer += dt;
+        if (animFrames > 1 && animTimer > (1.0f / animFPS))
+        {
+            animFrame = (animFrame + 1) % max(1, animFrames);
+            animTimer = 0;
+        }
+
+        // Apply texture and frame
+        if (seqSheet)
+        {
+            sprite.setTexture(*seqSheet);
+            IntRect r = getRectForFrame(seqSheet, seqStart + animFrame);
+            if (facingRight)
+            {
+                IntRect rflip(r.left + r.width, r.top, -r.width, r.height);
+                sprite.setTextureRect(rflip);
+            }
+            else
+            {
+                sprite.setTextureRect(r);
+            }
+            frameW = r.width;
+            frameH = r.height;
+        }
+
+        // Update sprite position and orientation
+        float spriteX = x + (frameW * PLAYER_SCALE) / 2.0f;
+        float spriteY = y + (frameH * PLAYER_SCALE);
+        if (onGround)
+            spriteY += (GROUND_SNAP_PX + 2.0f) * PLAYER_SCALE;
+        sprite.setPosition(spriteX - (frameW * PLAYER_SCALE) / 2.0f,
+                           spriteY - (frameH * PLAYER_SCALE));
+        // strict compliance: no origin; adjust position when placing
+
+        // Compute grid position under player's feet and at horizontal center
+        int footRow = (int)((y + (frameH * PLAYER_SCALE)) / CELL_SIZE);
+        int centerCol = (int)((x + (frameW * PLAYER_SCALE) / 2.0f) / CELL_SIZE);
+        // Slope tiles are 'S', '/' (down-right), '\\' (down-left); off the map reads empty
+        unsigned tile = tiles.at(footRow, centerCol);
+        bool onSlope = (tile & TILE_SLOPE) != 0;
+
+        if (onSlope)
+        {
+            // Choose a neighbor tile to define slope direction
+            int nrow = footRow;
+            int ncol = centerCol + 1;
+            if (ncol >= levelWidth)
+                ncol = levelWidth - 1;
+            if (tile & TILE_STAIR)
+            {
+                // For generic 'S', check diagonal neighbors to resolve slope
+                int r1 = std::min(levelHeight - 1, footRow + 1);
+                int c1 = std::min(levelWidth - 1, centerCol + 1);
+                int r2 = std::min(levelHeight - 1, footRow + 1);
+                int c2 = std::max(0, centerCol - 1);
+                if (tiles.has(r1, c1, TILE_STAIR))
+                {
+                    nrow = r1;
+                    ncol = c1;
+                }
+                else if (tiles.has(r2, c2, TILE_STAIR))
+                {
+                    nrow = r2;
+                    ncol = c2;
+                }
+            }
+
+            // Compute slope normal and angle for sprite rotation
+            float sx = centerCol * CELL_SIZE + CELL_SIZE / 2.0f;
+            float sy = (float)tiles.surfaceY(footRow, centerCol);
+            float ex = ncol * CELL_SIZE + CELL_SIZE / 2.0f;
+            float ey = (float)tiles.surfaceY(nrow, ncol);
+            float tx = ex - sx;
+            float ty = ey - sy;
+            float nx = -ty;
+            float ny = tx;
+            float slopeAngle = std::atan2(ny, nx) * 180.0f / 3.14159265f;
+
+            // Determine downhill direction along the slope
+            int downhill = 0;
+            if (ey > sy)
+            {
+                downhill = (ex > sx) ? 1 : -1;
+            }
+            else if (ey < sy)
+            {
+                downhill = (ex > sx) ? -1 : 1;
+            }
+
+            if (onGround && std::fabs(velocityX) > 0.1f)
+            {
+                animState = P_SLIDE;
+            }
+            // Align sprite to slope top and rotate to match angle
+            sprite.setPosition(spriteX - (frameW * PLAYER_SCALE) / 2.0f,
+                               (float)tiles.surfaceY(footRow, centerCol) - (frameH * PLAYER_SCALE));
+            // strict compliance: no rotation, adjust Y to align visually
+            // keep same placement by nudging position along slope
+        }
+        else
+        {
+            // Reset rotation on flat ground
+            // rotation reset not needed under strict mode
+        }
+
+        // Flip horizontally when facing right (because frames are drawn mirrored)
+        sprite.setScale(PLAYER_SCALE, PLAYER_SCALE);
+    }
+
+    void checkCollisions(const TileGrid &tiles)
+    {
+        // Start as airborne until a support tile is detected beneath the feet
+        onGround = false;
+
+        int playerWidth = (int)(frameW * PLAYER_SCALE);
+        int playerHeight = (int)(frameH * PLAYER_SCALE);
+
+        int baseRow = (int)((y + playerHeight + 2) / CELL_SIZE);
+        int leftX = (int)((x + 10) / CELL_SIZE);
+        int rightX = (int)((x + playerWidth - 10) / CELL_SIZE);
+        int centerX = (int)((x + playerWidth / 2) / CELL_SIZE);
+
+        // Supported when the center foot sample, or both outer ones, stand on floor
+        auto isSolidAtRow = [&](int row)
+        {
+            return tiles.has(row, centerX, TILE_FLOOR) ||
+                   (tiles.has(row, leftX, TILE_FLOOR) && tiles.has(row, rightX, TILE_FLOOR));
+        };
+
+        if (velocityY < 0)
+        {
+            int headRow = (int)((y - 2) / CELL_SIZE);
+            float headOffset = facingRight ? 8.0f : -8.0f;
+            int headLeftCol = (int)((x + headOffset + playerWidth * 0.25f) / CELL_SIZE);
+            int headCenterCol = (int)((x + headOffset + playerWidth * 0.5f) / CELL_SIZE);
+            int headRightCol = (int)((x + headOffset + playerWidth * 0.75f) / CELL_SIZE);
+            // Ramps are one-way; only '#' stops a rising head
+            int solids = 0;
+            if (tiles.has(headRow, headLeftCol, TILE_SOLID)) solids++;
+            if (tiles.has(headRow, headCenterCol, TILE_SOLID)) solids++;
+            if (tiles.has(headRow, headRightCol, TILE_SOLID)) solids++;
+            if (solids >= 2)
+            {
+                y = (headRow + 1) * CELL_SIZE;
+                velocityY = 0;
+            }
+        }
+
+        int hitRow = -1;
+        if (isSolidAtRow(baseRow))
+            hitRow = baseRow;
+        else if (isSolidAtRow(baseRow + 1))
+            hitRow = baseRow + 1;
+        else if (isSolidAtRow(baseRow - 1))
+            hitRow = baseRow - 1;
+
+        // If a blocking tile was found, snap Y to its top and zero vertical velocity
+        if (hitRow != -1)
+        {
+            int topY = tiles.surfaceY(hitRow, centerX) - playerHeight;
+            if (velocityY >= 0 || y > topY)
+            {
+                y = topY;
+                velocityY = 0;
+                onGround = true;
+            }
         }
-        if (powerBoostTimer > 0)
+
+        if (x < 0)
+            x = 0;
+        if (x > world_width() - playerWidth)
+            x = world_width() - playerWidth;
+        if (y > world_height() - playerHeight)
         {
-            powerBoostTimer -= dt;
-            if (powerBoostTimer <= 0)
-                vacuumRange = baseVacuumRange;
+            y = world_height() - playerHeight;
+            velocityY = 0;
+            onGround = true;
         }
     }
 
-    void captureEnemy(int type)
+    void reset(int level)
     {
-        if (capturedCount < maxCapacity)
-        {
-            capturedEnemies[capturedCount++] = type;
-        }
+        x = 100;
+        y = 700;
+        velocityX = 0;
+        velocityY = 0;
+        health = 3;
+        onGround = false;
+        facingRight = true;
+        capturedCount = 0;
+        maxCapacity = (level == 1) ? 3 : 5;
+        speed = baseSpeed;
+        vacuumRange = baseVacuumRange;
+        vacuumAngle = baseVacuumAngle;
+        speedBoostTimer = 0;
+        rangeBoostTimer = 0;
+        powerBoostTimer = 0;
+        jumpBoostTimer = 0.0f;
+        for (int i = 0; i < 5; i++)
+            capturedEnemies[i] = -1;
     }
 
-    int releaseOneEnemy()
+    float getCenterX() { return x + (frameW * PLAYER_SCALE) / 2; }
+    float getCenterY() { return y + (frameH * PLAYER_SCALE) / 2; }
+    int getWidth() { return (int)(frameW * PLAYER_SCALE); }
+    int getHeight() { return (int)(frameH * PLAYER_SCALE); }
+    int getFrameWidth() const { return frameW; }
+    int getFrameHeight() const { return frameH; }
+
+    FloatRect getHitbox() const
     {
-        if (capturedCount > 0)
+        float left = x + 28.0f * PLAYER_SCALE;
+        float top = y + 20.0f * PLAYER_SCALE;
+        float width = 0.42f * frameW * PLAYER_SCALE;
+        float height = 0.80f * frameH * PLAYER_SCALE;
+        return FloatRect(left, top, width, height);
+    }
+};
+
+// ============================================================================
+// ENEMY TYPE METADATA
+// ============================================================================
+// Frame rects and animation label ranges depend only on the enemy type and its
+// sheet, so they are built once per (type, sheet) and shared by every enemy of
+// that kind instead of being copied into each instance.
+struct EnemyTypeMeta
+{
+    static const int MAX_ROWS = 4;
+
+    std::vector<std::vector<IntRect>> rowRects;
+    AnimLabelTable labels;
+    AnimLabelTable rowLabels[MAX_ROWS];
+
+    static const EnemyTypeMeta &forSheet(int type, const Texture *tex)
+    {
+        static std::map<std::pair<int, const Texture *>, EnemyTypeMeta> registry;
+        std::pair<int, const Texture *> key(type, tex);
+        std::map<std::pair<int, const Texture *>, EnemyTypeMeta>::iterator it = registry.find(key);
+        if (it == registry.end())
         {
-            int type = capturedEnemies[--capturedCount];
-            capturedEnemies[capturedCount] = -1;
-            return type;
+            it = registry.insert(std::make_pair(key, EnemyTypeMeta())).first;
+            it->second.build(type, tex);
         }
-        return -1;
+        return it->second;
     }
 
-    void releaseAllEnemies(int *types, int &count)
+    // Placeholder for enemies that have not been bound to a sheet yet
+    static const EnemyTypeMeta &none()
     {
-        count = capturedCount;
-        for (int i = 0; i < capturedCount; i++)
-            types[i] = capturedEnemies[capturedCount - 1 - i];
-        capturedCount = 0;
-        for (int i = 0; i < 5; i++)
-            capturedEnemies[i] = -1;
+        static EnemyTypeMeta empty;
+        return empty;
     }
 
-    void update(float dt, char **map)
+    bool build(int type, const Texture *texPtr)
     {
-        // Decrement powerup timers and restore base speed/range/angle when expired
-        updatePowerups(dt);
+        rowRects.clear();
+        labels.clear();
+        for (int r = 0; r < MAX_ROWS; ++r)
+            rowLabels[r].clear();
+        buildFrameRects(type, texPtr);
 
-        // Physics
-        if (!onGround)
+        if (type == 2)
         {
-            velocityY += GRAVITY;
-            if (velocityY > TERMINAL_VELOCITY)
-                velocityY = TERMINAL_VELOCITY;
+            int frames = (!rowRects.empty()) ? (int)rowRects[0].size() : 0;
+            int idleA = 0;
+            int idleB = std::max(0, std::min(frames - 1, 3));
+            int runA = std::min(frames > 0 ? idleB + 1 : 0, std::max(0, frames - 5));
+            int runB = std::max(0, std::min(frames - 1, runA + 10));
+            int spinA = std::max(0, frames - 8);
+            int spinB = std::max(0, frames - 5);
+            int recA = std::max(0, frames - 4);
+            int recB = std::max(0, frames - 1);
+            labels.set(ANIM_IDLE, idleA, idleB);
+            labels.set(ANIM_RUN, runA, runB);
+            labels.set(ANIM_SPIN, spinA, spinB);
+            labels.set(ANIM_RECOVER, recA, recB);
+        }
+        else if (type == 3)
+        {
+            int frames = (!rowRects.empty()) ? (int)rowRects[0].size() : 0;
+            int walkC = std::min(6, std::max(1, frames));
+            int jumpC = std::min(3, std::max(0, frames - walkC));
+            int atkC = std::min(3, std::max(0, frames - walkC - jumpC));
+            int walkS = 0;
+            int jumpS = walkS + walkC;
+            int atkS = jumpS + jumpC;
+            rowLabels[0].set(ANIM_WALK, walkS, walkS + walkC - 1);
+            rowLabels[1].set(ANIM_JUMP, jumpS, jumpS + jumpC - 1);
+            rowLabels[2].set(ANIM_ATTACK_ORB, atkS, atkS + atkC - 1);
+        }
+        else if (type == 1)
+        {
+            int frames = (!rowRects.empty()) ? (int)rowRects[0].size() : 0;
+            int idleA = 0;
+            int idleB = std::max(0, std::min(frames - 1, 6));
+            labels.set(ANIM_IDLE, idleA, idleB);
+            labels.set(ANIM_CAPTURE, std::min(frames - 1, 25), std::min(frames - 1, 33));
+            labels.set(ANIM_HIT, std::min(frames - 1, 19), std::min(frames - 1, 24));
+        }
+        else if (type == 0)
+        {
+            int frames = (!rowRects.empty()) ? (int)rowRects[0].size() : 0;
+            int idleA = 0;
+            int idleB = std::max(0, std::min(frames - 1, 5));
+            int chaseA = std::min(frames - 1, idleB + 1);
+            int chaseB = std::max(chaseA, std::min(frames - 1, chaseA + 10));
+            int chargeA = std::max(chaseB + 1, frames / 2);
+            int chargeB = std::max(chargeA, std::min(frames - 1, chargeA + 2));
+            labels.set(ANIM_IDLE, idleA, idleB);
+            labels.set(ANIM_CHASE, chaseA, chaseB);
+            labels.set(ANIM_CHARGE, chargeA, chargeB);
         }
 
-        // Apply horizontal movement scaled by frame time; vertical moves by velocityY
-        x += velocityX * dt * 60.0f;
-        y += velocityY;
-
-        checkCollisions(map);
+        return !rowRects.empty();
+    }
 
-        // Track time spent in current animation state; treat tiny velocities as standing
-        animStateTimer += dt;
-        bool movingHoriz = fabs(velocityX) > 0.1f;
+    void buildFrameRects(int type, const Texture *texPtr)
+    {
+        rowRects.clear();
+        if (!texPtr || sheetSize(*texPtr).x == 0 || sheetSize(*texPtr).y == 0)
+            return;
+        int W = (int)sheetSize(*texPtr).x;
+        int H = (int)sheetSize(*texPtr).y;
 
-        // Store previous state for transition detection
-        prevAnimState = animState;
+        // MASTERCLASS: Use actual sprite dimensions based on enemy type
+        int fh = H;                 // Use full height for horizontal strip sprites
+        int fw = ENEMY_FRAME_WIDTH; // 64 pixel frame width
 
-        // Gate early exit when in hurt/knockdown/shoot sequences; otherwise evaluate movement
-        if (!(animState == P_HURT && animStateTimer < 0.35f) &&
-            !(animState == P_KNOCKDOWN && animStateTimer < 0.5f) &&
-            !(animState == P_SHOOT && animStateTimer < 0.3f) &&
-            !(animState == P_SHOOT_FORWARD && animStateTimer < 0.3f) &&
-            !(animState == P_SHOOT_SIDE && animStateTimer < 0.3f))
+        // Chelnov uses a 3x4 grid layout
+        if (type == 3)
         {
-
-            if (onGround)
-            {
-                if (!movingHoriz)
-                {
-                    animState = P_IDLE;
-                }
-                else
-                {
-                    animState = (speedBoostTimer > 0) ? P_POWER_RUN : P_RUN;
-                }
-            }
-            else
+            int cols = 3;
+            int rows = 4;
+            int tileW = std::max(1, W / cols);
+            int tileH = std::max(1, H / rows);
+            for (int r = 0; r < rows; ++r)
             {
-                // Choose jump phase based on vertical velocity thresholds
-                if (velocityY < -9.0f)
-                {
-                    animState = P_JUMP_START;
-                }
-                else if (velocityY < -2.0f)
-                {
-                    animState = P_JUMP_MID;
-                }
-                else if (fabs(velocityY) < 1.8f)
-                {
-                    animState = P_JUMP_PEAK;
-                }
-                else if (velocityY > 0)
+                std::vector<IntRect> rects;
+                int y0 = r * tileH;
+                int h = (r == rows - 1) ? (H - y0) : tileH;
+                for (int i = 0; i < cols; ++i)
                 {
-                    animState = P_FALL;
+                    int x0 = i * tileW;
+                    int w = (i == cols - 1) ? (W - x0) : tileW;
+                    rects.push_back(IntRect(x0, y0, w, h));
                 }
+                rowRects.push_back(rects);
             }
+            return;
         }
 
-        // Reset animation frame if state changed
-        if (animState != prevAnimState)
+        // MASTERCLASS: For horizontal strip sprites (ghost, skeleton, invisible)
+        // Calculate proper frame width based on sprite analysis
+        int framesPerRow = std::max(1, W / fw);
+
+        // Single row sprite sheets (ghost, skeleton, invisible are all single row)
+        std::vector<IntRect> rects;
+        rects.reserve(framesPerRow);
+        for (int i = 0; i < framesPerRow; ++i)
         {
-            animFrame = 0;
-            animTimer = 0;
-            animStateTimer = 0;
+            rects.push_back(IntRect(i * fw, 0, fw, fh));
         }
+        rowRects.push_back(rects);
+    }
+};
 
-        // Get current animation sequence
-        AnimSequence &anim = animations[animState];
-        seqSheet = anim.texture;
-        seqStart = anim.startFrame;
-        animFrames = anim.frameCount;
-        animFPS = anim.fps;
+// ============================================================================
+// ENEMY MOTION
+// ============================================================================
+// Position, velocity and liveness of every enemy in the level as parallel
+// arrays indexed by enemy id. These are the storage of record: Enemy reads and
+// writes them through its accessors, and gravity, motion, tile collision,
+// separation and the broad phase sweep them directly. The Enemy records keep
+// the sprite, animation and AI timers.
+class EnemyMotion
+{
+public:
+    std::vector<float> x, y, velocityX, velocityY;
+    std::vector<float> width, height;
+    std::vector<unsigned char> active, captured, onGround;
+    std::vector<unsigned char> holdX;    // paused: no horizontal motion
+    std::vector<unsigned char> anchored; // no motion at all (Chelnov's attack)
+    std::vector<float> margin;           // distance kept from the world edges
+    std::vector<float> stepDt;           // time to integrate next sweep; 0 = none
 
-        // Update animation frame
-        animTimer += dt;
-        if (animFrames > 1 && animTimer > (1.0f / animFPS))
-        {
-            animFrame = (animFrame + 1) % max(1, animFrames);
-            animTimer = 0;
-        }
+    size_t size() const { return x.size(); }
 
-        // Apply texture and frame
-        if (seqSheet)
-        {
-            sprite.setTexture(*seqSheet);
-            IntRect r = getRectForFrame(seqSheet, seqStart + animFrame);
-            if (facingRight)
-            {
-                IntRect rflip(r.left + r.width, r.top, -r.width, r.height);
-                sprite.setTextureRect(rflip);
-            }
-            else
-            {
-                sprite.setTextureRect(r);
-            }
-            frameW = r.width;
-            frameH = r.height;
-        }
+    int add(float sx, float sy, float edgeMargin)
+    {
+        x.push_back(sx);
+        y.push_back(sy);
+        velocityX.push_back(0);
+        velocityY.push_back(0);
+        width.push_back(ENEMY_FRAME_WIDTH * ENEMY_SCALE);
+        height.push_back(ENEMY_FRAME_HEIGHT * ENEMY_SCALE);
+        active.push_back(1);
+        captured.push_back(0);
+        onGround.push_back(0);
+        holdX.push_back(0);
+        anchored.push_back(0);
+        margin.push_back(edgeMargin);
+        stepDt.push_back(0);
+        return (int)x.size() - 1;
+    }
 
-        // Update sprite position and orientation
-        float spriteX = x + (frameW * PLAYER_SCALE) / 2.0f;
-        float spriteY = y + (frameH * PLAYER_SCALE);
-        if (onGround)
-            spriteY += (GROUND_SNAP_PX + 2.0f) * PLAYER_SCALE;
-        sprite.setPosition(spriteX - (frameW * PLAYER_SCALE) / 2.0f,
-                           spriteY - (frameH * PLAYER_SCALE));
-        // strict compliance: no origin; adjust position when placing
+    void clear()
+    {
+        x.clear();
+        y.clear();
+        velocityX.clear();
+        velocityY.clear();
+        width.clear();
+        height.clear();
+        active.clear();
+        captured.clear();
+        onGround.clear();
+        holdX.clear();
+        anchored.clear();
+        margin.clear();
+        stepDt.clear();
+    }
 
-        // Compute grid position under player's feet and at horizontal center
-        int footRow = (int)((y + (frameH * PLAYER_SCALE)) / CELL_SIZE);
-        int centerCol = (int)((x + (frameW * PLAYER_SCALE) / 2.0f) / CELL_SIZE);
-        // Read tile type; default to empty
-        char tile = ' ';
-        if (footRow >= 0 && footRow < LEVEL_HEIGHT && centerCol >= 0 && centerCol < LEVEL_WIDTH)
-            tile = map[footRow][centerCol];
-        // Slope tiles are marked as 'S', '/' (down-right), '\\' (down-left)
-        bool onSlope = (tile == 'S' || tile == '/' || tile == '\\');
+    bool live(size_t i) const { return active[i] && !captured[i]; }
+    int footRow(size_t i) const { return (int)((y[i] + height[i]) / CELL_SIZE); }
+    FloatRect box(size_t i) const { return FloatRect(x[i], y[i], width[i], height[i]); }
 
-        if (onSlope)
+    // Gravity, motion and tile collision for every live enemy the AI stepped
+    // this tick. Velocities are per 60 Hz tick, so a step longer than one fixed
+    // step (far enemies on their stride) runs as FIXED_DT substeps: jump heights
+    // and landings match the full-rate result.
+    void integrate(const TileGrid &tiles)
+    {
+        for (size_t i = 0; i < x.size(); i++)
         {
-            // Choose a neighbor tile to define slope direction
-            int nrow = footRow;
-            int ncol = centerCol + 1;
-            if (ncol >= LEVEL_WIDTH)
-                ncol = LEVEL_WIDTH - 1;
-            if (tile == 'S')
+            float dt = stepDt[i];
+            stepDt[i] = 0;
+            if (dt <= 0 || !live(i))
+                continue;
+
+            if (!anchored[i])
             {
-                // For generic 'S', check diagonal neighbors to resolve slope
-                int r1 = std::min(LEVEL_HEIGHT - 1, footRow + 1);
-                int c1 = std::min(LEVEL_WIDTH - 1, centerCol + 1);
-                int r2 = std::min(LEVEL_HEIGHT - 1, footRow + 1);
-                int c2 = std::max(0, centerCol - 1);
-                if (map[r1][c1] == 'S')
-                {
-                    nrow = r1;
-                    ncol = c1;
-                }
-                else if (map[r2][c2] == 'S')
+                int steps = std::max(1, (int)std::ceil(dt / FIXED_DT - 0.01f));
+                float step = dt * 60.0f / steps;
+                for (int k = 0; k < steps; k++)
                 {
-                    nrow = r2;
-                    ncol = c2;
+                    if (!onGround[i])
+                    {
+                        velocityY[i] += GRAVITY * step;
+                        if (velocityY[i] > TERMINAL_VELOCITY)
+                            velocityY[i] = TERMINAL_VELOCITY;
+                    }
+                    if (!holdX[i])
+                        x[i] += velocityX[i] * step;
+                    y[i] += velocityY[i] * step;
+                    collide(i, tiles);
                 }
             }
 
-            // Compute slope normal and angle for sprite rotation
-            float sx = centerCol * CELL_SIZE + CELL_SIZE / 2.0f;
-            float sy = (float)platformTopYAt(footRow, centerCol);
-            float ex = ncol * CELL_SIZE + CELL_SIZE / 2.0f;
-            float ey = (float)platformTopYAt(nrow, ncol);
-            float tx = ex - sx;
-            float ty = ey - sy;
-            float nx = -ty;
-            float ny = tx;
-            float slopeAngle = std::atan2(ny, nx) * 180.0f / 3.14159265f;
-
-            // Determine downhill direction along the slope
-            int downhill = 0;
-            if (ey > sy)
+            float left = margin[i];
+            float right = world_width() - width[i] - margin[i];
+            if (x[i] < left)
             {
-                downhill = (ex > sx) ? 1 : -1;
-            }
-            else if (ey < sy)
-            {
-                downhill = (ex > sx) ? -1 : 1;
+                x[i] = left;
+                velocityX[i] = fabs(velocityX[i]);
             }
-
-            // Read input to bias slide speed against/with the slope
-            bool leftNow = sf::Keyboard::isKeyPressed(sf::Keyboard::Left);
-            bool rightNow = sf::Keyboard::isKeyPressed(sf::Keyboard::Right);
-            int inputDir = rightNow ? 1 : (leftNow ? -1 : 0);
-            if (onGround && std::fabs(velocityX) > 0.1f)
+            if (x[i] > right)
             {
-                animState = P_SLIDE;
+                x[i] = right;
+                velocityX[i] = -fabs(velocityX[i]);
             }
-            // Align sprite to slope top and rotate to match angle
-            sprite.setPosition(spriteX - (frameW * PLAYER_SCALE) / 2.0f,
-                               (float)platformTopYAt(footRow, centerCol) - (frameH * PLAYER_SCALE));
-            // strict compliance: no rotation, adjust Y to align visually
-            // keep same placement by nudging position along slope
-        }
-        else
-        {
-            // Reset rotation on flat ground
-            // rotation reset not needed under strict mode
         }
-
-        // Flip horizontally when facing right (because frames are drawn mirrored)
-        sprite.setScale(PLAYER_SCALE, PLAYER_SCALE);
     }
 
-    void checkCollisions(char **map)
+    void collide(size_t i, const TileGrid &tiles)
     {
-        // Start as airborne until a support tile is detected beneath the feet
-        onGround = false;
-
-        int playerWidth = (int)(frameW * PLAYER_SCALE);
-        int playerHeight = (int)(frameH * PLAYER_SCALE);
+        onGround[i] = 0;
 
-        int baseRow = (int)((y + playerHeight + 2) / CELL_SIZE);
-        int leftX = (int)((x + 10) / CELL_SIZE);
-        int rightX = (int)((x + playerWidth - 10) / CELL_SIZE);
-        int centerX = (int)((x + playerWidth / 2) / CELL_SIZE);
+        int baseRow = (int)((y[i] + height[i] + 2) / CELL_SIZE);
+        int leftX = (int)((x[i] + 5) / CELL_SIZE);
+        int rightX = (int)((x[i] + width[i] - 5) / CELL_SIZE);
+        int centerX = (int)((x[i] + width[i] / 2) / CELL_SIZE);
 
-        // Test if any of the three foot samples hit a solid or sloped tile
+        // Any floor cell under the feet, left edge to right edge
         auto isSolidAtRow = [&](int row)
         {
-            if (row < 0 || row >= LEVEL_HEIGHT)
-                return false;
-            bool leftSolid = (leftX >= 0 && leftX < LEVEL_WIDTH && (map[row][leftX] == '#' || map[row][leftX] == '/' || map[row][leftX] == '\\' || map[row][leftX] == 'S'));
-            bool centerSolid = (centerX >= 0 && centerX < LEVEL_WIDTH && (map[row][centerX] == '#' || map[row][centerX] == '/' || map[row][centerX] == '\\' || map[row][centerX] == 'S'));
-            bool rightSolid = (rightX >= 0 && rightX < LEVEL_WIDTH && (map[row][rightX] == '#' || map[row][rightX] == '/' || map[row][rightX] == '\\' || map[row][rightX] == 'S'));
-            return centerSolid || (leftSolid && rightSolid);
+            return tiles.any(row, leftX, rightX, TILE_FLOOR);
         };
 
-        if (velocityY < 0)
-        {
-            int headRow = (int)((y - 2) / CELL_SIZE);
-            auto solidAt = [&](int row, int col)
-            {
-                if (row >= 0 && row < LEVEL_HEIGHT && col >= 0 && col < LEVEL_WIDTH)
-                    return map[row][col] == '#';
-                return false;
-            };
-            float headOffset = facingRight ? 8.0f : -8.0f;
-            int headLeftCol = (int)((x + headOffset + playerWidth * 0.25f) / CELL_SIZE);
-            int headCenterCol = (int)((x + headOffset + playerWidth * 0.5f) / CELL_SIZE);
-            int headRightCol = (int)((x + headOffset + playerWidth * 0.75f) / CELL_SIZE);
-            int solids = 0;
-            if (solidAt(headRow, headLeftCol)) solids++;
-            if (solidAt(headRow, headCenterCol)) solids++;
-            if (solidAt(headRow, headRightCol)) solids++;
-            if (solids >= 2)
-            {
-                y = (headRow + 1) * CELL_SIZE;
-                velocityY = 0;
-            }
-        }
-
         int hitRow = -1;
         if (isSolidAtRow(baseRow))
             hitRow = baseRow;
@@ -1190,80 +3480,33 @@ public:
         else if (isSolidAtRow(baseRow - 1))
             hitRow = baseRow - 1;
 
-        // If a blocking tile was found, snap Y to its top and zero vertical velocity
-        if (hitRow != -1)
+        if (hitRow != -1 && velocityY[i] >= 0)
         {
-            int topY = platformTopYAt(hitRow, centerX) - playerHeight;
-            if (velocityY >= 0 || y > topY)
-            {
-                y = topY;
-                velocityY = 0;
-                onGround = true;
-            }
+            y[i] = tiles.surfaceY(hitRow, centerX) - height[i];
+            velocityY[i] = 0;
+            onGround[i] = 1;
         }
 
-        if (x < 0)
-            x = 0;
-        if (x > SCREEN_WIDTH - playerWidth)
-            x = SCREEN_WIDTH - playerWidth;
-        if (y > SCREEN_HEIGHT - playerHeight)
+        if (y[i] > world_height() - height[i])
         {
-            y = SCREEN_HEIGHT - playerHeight;
-            velocityY = 0;
-            onGround = true;
+            y[i] = world_height() - height[i];
+            velocityY[i] = 0;
+            onGround[i] = 1;
         }
     }
-
-    void reset(int level)
-    {
-        x = 100;
-        y = 700;
-        velocityX = 0;
-        velocityY = 0;
-        health = 3;
-        onGround = false;
-        facingRight = true;
-        capturedCount = 0;
-        maxCapacity = (level == 1) ? 3 : 5;
-        speed = baseSpeed;
-        vacuumRange = baseVacuumRange;
-        vacuumAngle = baseVacuumAngle;
-        speedBoostTimer = 0;
-        rangeBoostTimer = 0;
-        powerBoostTimer = 0;
-        jumpBoostTimer = 0.0f;
-        for (int i = 0; i < 5; i++)
-            capturedEnemies[i] = -1;
-    }
-
-    float getCenterX() { return x + (frameW * PLAYER_SCALE) / 2; }
-    float getCenterY() { return y + (frameH * PLAYER_SCALE) / 2; }
-    int getWidth() { return (int)(frameW * PLAYER_SCALE); }
-    int getHeight() { return (int)(frameH * PLAYER_SCALE); }
-    int getFrameWidth() const { return frameW; }
-    int getFrameHeight() const { return frameH; }
-
-    FloatRect getHitbox() const
-    {
-        float left = x + 28.0f * PLAYER_SCALE;
-        float top = y + 20.0f * PLAYER_SCALE;
-        float width = 0.42f * frameW * PLAYER_SCALE;
-        float height = 0.80f * frameH * PLAYER_SCALE;
-        return FloatRect(left, top, width, height);
-    }
 };
 
 // ============================================================================
 // ENEMY CLASS - ENHANCED ANIMATIONS
 // ============================================================================
+// AI, animation and rendering state of one enemy. Its motion lives in
+// EnemyMotion at index id; x(), velocityX() and friends reference it there.
 class Enemy
 {
 public:
-    float x, y;
-    float velocityX, velocityY;
+    EnemyMotion *hot;
+    int id;
     int type;
-    bool active;
-    bool captured;
     int capturePoints;
     float stateTimer;
     float actionTimer;
@@ -1271,7 +3514,6 @@ public:
     bool isVisible;
     bool isShooting;
     bool hasFired;
-    bool onGround;
     float jumpCooldown;
     bool facingRight;
 
@@ -1292,6 +3534,7 @@ public:
     float invisibleTimer;
 
     Sprite sprite;
+    RenderLerp lerp;
     Texture *texPtr;
     Texture *texDimPtr;
     int texRows;
@@ -1300,41 +3543,36 @@ public:
     int animFrames;
     float animFPS;
     int seqStart;
-    std::vector<std::vector<IntRect>> rowRects;
+    const EnemyTypeMeta *meta; // shared frame rects and label ranges
     int currW;
     int currH;
     int footPadPx;
-    std::map<std::string, std::pair<int, int>> metaLabels;
-    std::map<int, std::map<std::string, std::pair<int, int>>> metaLabelsPerRow;
 
-    // Initialize enemy with type and spawn position; set default behaviors and timers
-    Enemy(int t, float sx, float sy)
+    // Initialize enemy with type and its motion slot; set default behaviors and timers
+    Enemy(EnemyMotion &motion, int slot, int t)
     {
+        hot = &motion;
+        id = slot;
         type = t;
-        x = sx;
-        y = sy;
-        active = true;
-        captured = false;
-        velocityX = (rand() % 2 == 0) ? 2.0f : -2.0f;
-        velocityY = 0;
+        velocityX() = (rngAI.below(2) == 0) ? 2.0f : -2.0f;
+        velocityY() = 0;
         stateTimer = 0;
         actionTimer = 0;
         shootTimer = 0;
         isVisible = true;
         isShooting = false;
         hasFired = false;
-        onGround = false;
         jumpCooldown = 0;
-        facingRight = (velocityX > 0);
+        facingRight = (velocityX() > 0);
         animFrame = 0;
         animTimer = 0;
         rowChangeTimer = 0;
-        rowChangeInterval = 4.0f + (rand() % 300) / 100.0f;
+        rowChangeInterval = 4.0f + rngAI.below(300) / 100.0f;
         seekingDrop = false;
-        dropTargetX = x;
+        dropTargetX = x();
         pauseTimer = 0;
         jumpingAcross = false;
-        jumpTargetX = x;
+        jumpTargetX = x();
         jumpTargetRow = -1;
         teleporting = false;
         teleportTimer = 0;
@@ -1343,6 +3581,7 @@ public:
 
         texPtr = nullptr;
         texDimPtr = nullptr;
+        meta = &EnemyTypeMeta::none();
         texRows = 1;
         rowFrameCounts[0] = 26;
         rowFrameCounts[1] = 0;
@@ -1352,6 +3591,8 @@ public:
         animFrames = 4;
         animFPS = 4.0f;
         seqStart = 0;
+        currW = ENEMY_FRAME_WIDTH;
+        currH = ENEMY_FRAME_HEIGHT;
         footPadPx = 0;
 
         // Grant capture scores per enemy type
@@ -1372,39 +3613,31 @@ public:
         }
     }
 
-    bool isSolidAt(char **map, int row, int col)
-    {
-        return (row >= 0 && row < LEVEL_HEIGHT && col >= 0 && col < LEVEL_WIDTH && map[row][col] == '#');
-    }
-
-    void chooseReappearPosition(char **map, float playerX, float playerY, float &outX, float &outY)
+    void chooseReappearPosition(float playerX, float playerY, float &outX, float &outY)
     {
         int preferredCol = (int)(playerX / CELL_SIZE);
-        int playerRowIdx = std::max(0, std::min(LEVEL_HEIGHT - 1, (int)(playerY / CELL_SIZE)));
+        int playerRowIdx = std::max(0, std::min(levelHeight - 1, (int)(playerY / CELL_SIZE)));
 
         int bestRow = -1;
         int bestCol = preferredCol;
-        int bestDist = LEVEL_HEIGHT + 5;
-        for (int radius = 0; radius < LEVEL_WIDTH; ++radius)
+        int bestDist = levelHeight + 5;
+        for (int radius = 0; radius < levelWidth; ++radius)
         {
             int cands[2] = {preferredCol - radius, preferredCol + radius};
             for (int ci = 0; ci < 2; ++ci)
             {
                 int c = cands[ci];
-                if (c < 0 || c >= LEVEL_WIDTH)
+                if (c < 0 || c >= levelWidth)
                     continue;
-                for (int r = 0; r < LEVEL_HEIGHT; ++r)
+                int r = platformGraph.solidAtOrBelow(0, c); // topmost platform in c
+                if (r >= 0)
                 {
-                    if (isSolidAt(map, r, c))
+                    int d = std::abs(r - playerRowIdx);
+                    if (d < bestDist)
                     {
-                        int d = std::abs(r - playerRowIdx);
-                        if (d < bestDist)
-                        {
-                            bestDist = d;
-                            bestRow = r;
-                            bestCol = c;
-                        }
-                        break;
+                        bestDist = d;
+                        bestRow = r;
+                        bestCol = c;
                     }
                 }
             }
@@ -1414,17 +3647,12 @@ public:
 
         if (bestRow == -1)
         {
-            bestRow = std::max(0, std::min(LEVEL_HEIGHT - 1, playerRowIdx));
-            bestCol = std::max(0, std::min(LEVEL_WIDTH - 1, preferredCol));
+            bestRow = std::max(0, std::min(levelHeight - 1, playerRowIdx));
+            bestCol = std::max(0, std::min(levelWidth - 1, preferredCol));
         }
 
-        int leftCol = bestCol, rightCol = bestCol;
-        while (leftCol > 0 && isSolidAt(map, bestRow, leftCol))
-            leftCol--;
-        while (rightCol < LEVEL_WIDTH - 1 && isSolidAt(map, bestRow, rightCol))
-            rightCol++;
-        int segLeftCol = leftCol + 1;
-        int segRightCol = rightCol - 1;
+        int segLeftCol = platformGraph.walkLeft(bestRow, bestCol) + 1;
+        int segRightCol = platformGraph.walkRight(bestRow, bestCol) - 1;
 
         float segLeftX = segLeftCol * CELL_SIZE + 8.0f;
         float segRightX = segRightCol * CELL_SIZE + (CELL_SIZE - getWidth() - 8.0f);
@@ -1435,7 +3663,7 @@ public:
             float prefer = 0.5f;
             if (playerX >= segLeftX && playerX <= segRightX && width > 0)
                 prefer = (playerX - segLeftX) / width;
-            float jitter = ((rand() % 41) - 20) / 100.0f;
+            float jitter = (rngAI.below(41) - 20) / 100.0f;
             float mix = std::max(0.2f, std::min(0.8f, prefer + jitter));
             targetX = segLeftX + mix * std::max(0.0f, width);
         }
@@ -1444,43 +3672,15 @@ public:
         outY = bestRow * CELL_SIZE - getHeight() - 2.0f;
     }
 
-    bool findJumpTarget(char **map, int currentRow)
+    bool findJumpTarget(int currentRow)
     {
-        int centerCol = (int)((x + getWidth() / 2) / CELL_SIZE);
-        int targetRow = -1;
-
-        for (int r = currentRow - 1; r >= 0; --r)
-        {
-            if (isSolidAt(map, r, centerCol))
-            {
-                targetRow = r;
-                break;
-            }
-        }
-
-        if (targetRow == -1)
-        {
-            for (int r = currentRow + 1; r < LEVEL_HEIGHT; ++r)
-            {
-                if (isSolidAt(map, r, centerCol))
-                {
-                    targetRow = r;
-                    break;
-                }
-            }
-        }
-
+        int centerCol = (int)((x() + getWidth() / 2) / CELL_SIZE);
+        int targetRow = platformGraph.jumpRow(currentRow, centerCol);
         if (targetRow == -1)
             return false;
 
-        int leftCol = centerCol, rightCol = centerCol;
-        while (leftCol > 0 && isSolidAt(map, targetRow, leftCol))
-            leftCol--;
-        while (rightCol < LEVEL_WIDTH - 1 && isSolidAt(map, targetRow, rightCol))
-            rightCol++;
-
-        int segLeftCol = leftCol + 1;
-        int segRightCol = rightCol - 1;
+        int segLeftCol = platformGraph.walkLeft(targetRow, centerCol) + 1;
+        int segRightCol = platformGraph.walkRight(targetRow, centerCol) - 1;
         int targetCol = max(segLeftCol, min(centerCol, segRightCol));
 
         jumpTargetX = targetCol * CELL_SIZE + 8.0f;
@@ -1508,102 +3708,36 @@ public:
         return true;
     }
 
-    bool loadEnemyMetaForType()
-    {
-        rowRects.clear();
-        metaLabels.clear();
-        metaLabelsPerRow.clear();
-        buildEnemyFrameRects();
-
-        if (type == 2)
-        {
-            int frames = (!rowRects.empty()) ? (int)rowRects[0].size() : 0;
-            int idleA = 0;
-            int idleB = std::max(0, std::min(frames - 1, 3));
-            int runA = std::min(frames > 0 ? idleB + 1 : 0, std::max(0, frames - 5));
-            int runB = std::max(0, std::min(frames - 1, runA + 10));
-            int spinA = std::max(0, frames - 8);
-            int spinB = std::max(0, frames - 5);
-            int recA = std::max(0, frames - 4);
-            int recB = std::max(0, frames - 1);
-            metaLabels["idle"] = std::make_pair(idleA, idleB);
-            metaLabels["run"] = std::make_pair(runA, runB);
-            metaLabels["spin"] = std::make_pair(spinA, spinB);
-            metaLabels["recover"] = std::make_pair(recA, recB);
-        }
-        else if (type == 3)
-        {
-            int frames = (!rowRects.empty()) ? (int)rowRects[0].size() : 0;
-            int walkC = std::min(6, std::max(1, frames));
-            int jumpC = std::min(3, std::max(0, frames - walkC));
-            int atkC = std::min(3, std::max(0, frames - walkC - jumpC));
-            int walkS = 0;
-            int jumpS = walkS + walkC;
-            int atkS = jumpS + jumpC;
-            metaLabelsPerRow[0]["walk"] = std::make_pair(walkS, walkS + walkC - 1);
-            metaLabelsPerRow[1]["jump"] = std::make_pair(jumpS, jumpS + jumpC - 1);
-            metaLabelsPerRow[2]["attack_orb"] = std::make_pair(atkS, atkS + atkC - 1);
-        }
-        else if (type == 1)
-        {
-            int frames = (!rowRects.empty()) ? (int)rowRects[0].size() : 0;
-            int idleA = 0;
-            int idleB = std::max(0, std::min(frames - 1, 6));
-            metaLabels["idle"] = std::make_pair(idleA, idleB);
-            metaLabels["capture"] = std::make_pair(std::min(frames - 1, 25), std::min(frames - 1, 33));
-            metaLabels["hit"] = std::make_pair(std::min(frames - 1, 19), std::min(frames - 1, 24));
-        }
-        else if (type == 0)
-        {
-            int frames = (!rowRects.empty()) ? (int)rowRects[0].size() : 0;
-            int idleA = 0;
-            int idleB = std::max(0, std::min(frames - 1, 5));
-            int chaseA = std::min(frames - 1, idleB + 1);
-            int chaseB = std::max(chaseA, std::min(frames - 1, chaseA + 10));
-            int chargeA = std::max(chaseB + 1, frames / 2);
-            int chargeB = std::max(chargeA, std::min(frames - 1, chargeA + 2));
-            metaLabels["idle"] = std::make_pair(idleA, idleB);
-            metaLabels["chase"] = std::make_pair(chaseA, chaseB);
-            metaLabels["charge"] = std::make_pair(chargeA, chargeB);
-        }
-
-        return !rowRects.empty();
-    }
-
     // Bind texture, scale, and origin for consistent collision and rotation
     void setupSprite(Texture &tex, Texture *dimTex = nullptr)
     {
         texPtr = &tex;
         texDimPtr = dimTex;
         sprite.setTexture(tex);
-        bool loadedMeta = loadEnemyMetaForType();
-        if (!loadedMeta)
-            buildEnemyFrameRects();
-        texRows = (int)rowRects.size();
+        meta = &EnemyTypeMeta::forSheet(type, &tex);
+        texRows = (int)meta->rowRects.size();
         for (int r = 0; r < 4; ++r)
         {
-            rowFrameCounts[r] = (r < texRows) ? (int)rowRects[r].size() : 0;
+            rowFrameCounts[r] = (r < texRows) ? (int)meta->rowRects[r].size() : 0;
         }
 
         animRow = 0;
         seqStart = 0;
         animFrames = (rowFrameCounts[0] > 0) ? std::min(4, rowFrameCounts[0]) : 1;
-        animFPS = 6.0f + (rand() % 30) / 10.0f; // Varied animation speed
+        animFPS = 6.0f + rngFx.below(30) / 10.0f; // Varied animation speed
 
         IntRect r;
-        if (texRows > 0 && !rowRects[0].empty())
-            r = rowRects[0][0];
+        if (texRows > 0 && !meta->rowRects[0].empty())
+            r = meta->rowRects[0][0];
         else
         {
-            int inferredRows = std::max(1, (int)(tex.getSize().y / ENEMY_FRAME_HEIGHT));
-            int inferredFrames = std::max(1, (int)(tex.getSize().x / ENEMY_FRAME_WIDTH));
-            int fh = tex.getSize().y / std::max(1, inferredRows);
-            int fw = tex.getSize().x / std::max(1, inferredFrames);
+            int inferredRows = std::max(1, (int)(sheetSize(tex).y / ENEMY_FRAME_HEIGHT));
+            int inferredFrames = std::max(1, (int)(sheetSize(tex).x / ENEMY_FRAME_WIDTH));
+            int fh = sheetSize(tex).y / std::max(1, inferredRows);
+            int fw = sheetSize(tex).x / std::max(1, inferredFrames);
             r = IntRect(0, 0, fw, fh);
         }
-        sprite.setTextureRect(r);
-        currW = r.width;
-        currH = r.height;
+        setFrame(r);
         sprite.setScale(ENEMY_SCALE, ENEMY_SCALE);
 
         if (type == 0)
@@ -1612,75 +3746,37 @@ public:
             footPadPx = 0;
     }
 
-    void buildEnemyFrameRects()
+    // Show frame r and publish its size to the motion arrays
+    void setFrame(const IntRect &r)
     {
-        rowRects.clear();
-        if (!texPtr || texPtr->getSize().x == 0 || texPtr->getSize().y == 0)
-            return;
-        int W = (int)texPtr->getSize().x;
-        int H = (int)texPtr->getSize().y;
-
-        // MASTERCLASS: Use actual sprite dimensions based on enemy type
-        int fh = H;                 // Use full height for horizontal strip sprites
-        int fw = ENEMY_FRAME_WIDTH; // 64 pixel frame width
-
-        // Chelnov uses a 3x4 grid layout
-        if (type == 3)
-        {
-            int cols = 3;
-            int rows = 4;
-            int tileW = std::max(1, W / cols);
-            int tileH = std::max(1, H / rows);
-            for (int r = 0; r < rows; ++r)
-            {
-                std::vector<IntRect> rects;
-                int y0 = r * tileH;
-                int h = (r == rows - 1) ? (H - y0) : tileH;
-                for (int i = 0; i < cols; ++i)
-                {
-                    int x0 = i * tileW;
-                    int w = (i == cols - 1) ? (W - x0) : tileW;
-                    rects.push_back(IntRect(x0, y0, w, h));
-                }
-                rowRects.push_back(rects);
-            }
-            return;
-        }
-
-        // MASTERCLASS: For horizontal strip sprites (ghost, skeleton, invisible)
-        // Calculate proper frame width based on sprite analysis
-        int framesPerRow = std::max(1, W / fw);
-
-        // Single row sprite sheets (ghost, skeleton, invisible are all single row)
-        std::vector<IntRect> rects;
-        rects.reserve(framesPerRow);
-        for (int i = 0; i < framesPerRow; ++i)
-        {
-            rects.push_back(IntRect(i * fw, 0, fw, fh));
-        }
-        rowRects.push_back(rects);
+        sprite.setTextureRect(r);
+        currW = r.width;
+        currH = r.height;
+        hot->width[id] = (float)getWidth();
+        hot->height[id] = (float)getHeight();
     }
 
     IntRect getEnemyRect(int row, int index)
     {
-        if (row >= 0 && row < (int)rowRects.size() && !rowRects[row].empty())
+        if (row >= 0 && row < (int)meta->rowRects.size() && !meta->rowRects[row].empty())
         {
-            index = std::max(0, std::min(index, (int)rowRects[row].size() - 1));
-            return rowRects[row][index];
+            index = std::max(0, std::min(index, (int)meta->rowRects[row].size() - 1));
+            return meta->rowRects[row][index];
         }
-        if (!rowRects.empty())
+        if (!meta->rowRects.empty())
         {
-            int r0Count = (int)rowRects[0].size();
+            int r0Count = (int)meta->rowRects[0].size();
             index = std::max(0, std::min(index, r0Count - 1));
-            return rowRects[0][index];
+            return meta->rowRects[0][index];
         }
         int fh = ENEMY_FRAME_HEIGHT;
         return IntRect(index * ENEMY_FRAME_WIDTH, 0, ENEMY_FRAME_WIDTH, fh);
     }
 
-    void update(float dt, char **map, float playerX, float playerY)
+    // Runs the AI for dt and queues the same dt for EnemyMotion::integrate()
+    void update(float dt, float playerX, float playerY)
     {
-        if (!active || captured)
+        if (!active() || captured())
             return;
 
         stateTimer += dt;
@@ -1698,56 +3794,41 @@ public:
         {
             animFrame = (animFrame + 1) % max(1, animFrames);
             if (texPtr)
-            {
-                IntRect r = getEnemyRect(animRow, seqStart + animFrame);
-                sprite.setTextureRect(r);
-                currW = r.width;
-                currH = r.height;
-            }
+                setFrame(getEnemyRect(animRow, seqStart + animFrame));
             animTimer = 0;
         }
 
-        if (velocityX > 0)
+        if (velocityX() > 0)
             facingRight = true;
-        else if (velocityX < 0)
+        else if (velocityX() < 0)
             facingRight = false;
 
         switch (type)
         {
         case 0:
-            updateGhost(dt, map, playerX, playerY);
+            updateGhost(dt, playerX, playerY);
             break;
         case 1:
-            updateSkeleton(dt, map, playerX, playerY);
+            updateSkeleton(dt, playerX, playerY);
             break;
         case 2:
-            updateInvisibleMan(dt, map, playerX, playerY);
+            updateInvisibleMan(dt, playerX, playerY);
             break;
         case 3:
-            updateChelnov(dt, map, playerX, playerY);
+            updateChelnov(dt, playerX, playerY);
             break;
         }
 
         // Platform edge behavior
-        if (onGround)
+        if (onGround())
         {
-            int bottomY = (int)((y + getHeight() + 2) / CELL_SIZE);
-            int centerCol = (int)((x + getWidth() / 2) / CELL_SIZE);
-
-            auto isSolidBelow = [&](int col)
-            {
-                if (bottomY >= 0 && bottomY < LEVEL_HEIGHT && col >= 0 && col < LEVEL_WIDTH)
-                    return map[bottomY][col] == '#';
-                return false;
-            };
+            int bottomY = (int)((y() + getHeight() + 2) / CELL_SIZE);
+            int centerCol = (int)((x() + getWidth() / 2) / CELL_SIZE);
 
-            int leftBound = centerCol;
-            while (leftBound > 0 && isSolidBelow(leftBound))
-                leftBound--;
-
-            int rightBound = centerCol;
-            while (rightBound < LEVEL_WIDTH - 1 && isSolidBelow(rightBound))
-                rightBound++;
+            int leftBound = platformGraph.walkLeft(bottomY, centerCol);
+            int rightBound = platformGraph.walkRight(bottomY, centerCol);
+            const PlatformGraph::Link *route =
+                playerFlow.route(platformGraph, platformGraph.segmentAt(bottomY, centerCol));
 
             float segLeftX = (leftBound + 1) * CELL_SIZE + 8.0f;
             float segRightX = rightBound * CELL_SIZE + (CELL_SIZE - getWidth() - 8.0f);
@@ -1755,109 +3836,125 @@ public:
             if (!jumpingAcross)
             {
                 // Check for gap/edge
-                bool atEdge = (x <= segLeftX || x >= segRightX);
+                bool atEdge = (x() <= segLeftX || x() >= segRightX);
                 
                 if (atEdge)
                 {
                      // Try to jump first
-                    if (findJumpTarget(map, bottomY))
+                    if (findJumpTarget(bottomY))
                     {
                          jumpingAcross = true;
-                         velocityY = -9.0f;
+                         velocityY() = -9.0f;
                          // Jump towards target
-                         velocityX = (x < jumpTargetX) ? 2.0f : -2.0f; 
+                         velocityX() = (x() < jumpTargetX) ? 2.0f : -2.0f; 
                          jumpCooldown = 5.0f;
                     }
                     else
                     {
                          // Turn around if cannot jump
-                         if (x <= segLeftX) velocityX = 0.5f;
-                         else if (x >= segRightX) velocityX = -0.5f;
+                         if (x() <= segLeftX) velocityX() = 0.5f;
+                         else if (x() >= segRightX) velocityX() = -0.5f;
                     }
                 }
 
-                 if (pauseTimer <= 0 && fabs(velocityX) < 0.05f && !isShooting)
+                 if (pauseTimer <= 0 && fabs(velocityX()) < 0.05f && !isShooting)
+                {
+                    velocityX() = facingRight ? 0.5f : -0.5f;
+                }
+
+                // Pursuit: walk to the columns whose jump leads toward the
+                // player's platform and take it once the cooldown allows
+                if (route && pauseTimer <= 0 && !isShooting)
                 {
-                    velocityX = facingRight ? 0.5f : -0.5f;
+                    float walk = std::max(0.5f, (float)fabs(velocityX()));
+                    if (centerCol < route->colFirst)
+                        velocityX() = walk;
+                    else if (centerCol > route->colLast)
+                        velocityX() = -walk;
+                    else if (jumpCooldown <= 0 && findJumpTarget(bottomY))
+                    {
+                        jumpingAcross = true;
+                        velocityY() = -9.0f;
+                        velocityX() = (x() < jumpTargetX) ? walk : -walk;
+                        jumpCooldown = 5.0f;
+                    }
                 }
             }
 
-            if (!isShooting && pauseTimer <= 0 && jumpCooldown <= 0 && rand() % 100 < 2)
+            // Random hops only when there is no route to follow
+            if (!route && !isShooting && pauseTimer <= 0 && jumpCooldown <= 0 && rngAI.below(100) < 2)
             {
-                if (findJumpTarget(map, bottomY))
+                if (findJumpTarget(bottomY))
                 {
                     jumpingAcross = true;
-                    velocityY = -9.0f;
-                    velocityX = (x < jumpTargetX) ? fabs(velocityX) : -fabs(velocityX);
+                    velocityY() = -9.0f;
+                    velocityX() = (x() < jumpTargetX) ? fabs(velocityX()) : -fabs(velocityX());
                     jumpCooldown = 5.0f;
                 }
             }
         }
 
         rowChangeTimer += dt;
-        if (onGround && pauseTimer <= 0 && stateTimer > 1.5f && rand() % 100 < 3)
+        if (onGround() && pauseTimer <= 0 && stateTimer > 1.5f && rngAI.below(100) < 3)
         {
-            pauseTimer = 0.8f + (rand() % 40) / 100.0f;
-            velocityX = 0;
+            pauseTimer = 0.8f + rngAI.below(40) / 100.0f;
+            velocityX() = 0;
             stateTimer = 0;
         }
 
         if (jumpingAcross)
         {
-            if (x < jumpTargetX)
-                velocityX = 0.5f;
-            else if (x > jumpTargetX)
-                velocityX = -0.5f;
+            if (x() < jumpTargetX)
+                velocityX() = 0.5f;
+            else if (x() > jumpTargetX)
+                velocityX() = -0.5f;
 
-            if (onGround)
+            if (onGround())
             {
-                int bottomY = (int)((y + getHeight() + 2) / CELL_SIZE);
+                int bottomY = (int)((y() + getHeight() + 2) / CELL_SIZE);
                 if (bottomY == jumpTargetRow)
                 {
                     jumpingAcross = false;
                     jumpCooldown = 4.5f;
                     pauseTimer = 0.6f;
-                    velocityX = facingRight ? 0.5f : -0.5f;
+                    velocityX() = facingRight ? 0.5f : -0.5f;
                 }
             }
         }
 
+        hot->holdX[id] = pauseTimer > 0;
+        hot->anchored[id] = (type == 3 && isShooting);
+        hot->stepDt[id] = dt;
+    }
+
+    // Moves the sprite to the enemy's position once motion has run
+    void placeSprite()
+    {
         if (facingRight)
         {
             sprite.setScale(ENEMY_SCALE, ENEMY_SCALE);
-            sprite.setPosition(x, y + footPadPx * ENEMY_SCALE);
+            sprite.setPosition(x(), y() + footPadPx * ENEMY_SCALE);
         }
         else
         {
             sprite.setScale(-ENEMY_SCALE, ENEMY_SCALE);
-            sprite.setPosition(x + currW * ENEMY_SCALE, y + footPadPx * ENEMY_SCALE);
+            sprite.setPosition(x() + currW * ENEMY_SCALE, y() + footPadPx * ENEMY_SCALE);
         }
     }
 
-    void updateGhost(float dt, char **map, float playerX, float playerY)
+    void updateGhost(float dt, float playerX, float playerY)
     {
-        if (!onGround)
-        {
-            velocityY += GRAVITY;
-            if (velocityY > TERMINAL_VELOCITY)
-                velocityY = TERMINAL_VELOCITY;
-        }
-
         {
             float base = 2.0f;
-            velocityX = (velocityX >= 0) ? base : -base;
+            velocityX() = (velocityX() >= 0) ? base : -base;
         }
-        if (pauseTimer <= 0)
-            x += velocityX * dt * 60.0f;
-        y += velocityY * dt * 60.0f;
-        checkPlatformCollision(map);
 
-        if (pauseTimer <= 0 && stateTimer > 1.0f && rand() % 100 < 6)
+        if (pauseTimer <= 0 && stateTimer > 1.0f && rngAI.below(100) < 6)
         {
-            pauseTimer = 1.0f + (rand() % 80) / 100.0f;
+            pauseTimer = 1.0f + rngAI.below(80) / 100.0f;
             stateTimer = 0;
-            if (rand() % 100 < 50)
-                velocityX = -velocityX;
+            if (rngAI.below(100) < 50)
+                velocityX() = -velocityX();
         }
 
         float distX = fabs(getCenterX() - playerX);
@@ -1870,13 +3967,13 @@ public:
         int idleStart = 0, idleCount = min(7, framesInRow);
         int chaseStart = max(idleCount, framesInRow - 11), chaseCount = max(1, min(11, framesInRow - chaseStart));
         int chargeStart = max(idleCount, framesInRow / 2), chargeCount = max(1, min(2, framesInRow - chargeStart));
-        if (!metaLabels.empty())
+        if (!meta->labels.empty())
         {
-            auto setRange = [&](const std::string &name, int &s, int &c)
-            { auto it = metaLabels.find(name); if (it!=metaLabels.end()) { s = it->second.first; c = max(1, it->second.second - it->second.first + 0); } };
-            setRange("idle", idleStart, idleCount);
-            setRange("chase", chaseStart, chaseCount);
-            setRange("charge", chargeStart, chargeCount);
+            auto setRange = [&](AnimLabel label, int &s, int &c)
+            { int a, b; if (meta->labels.find(label, a, b)) { s = a; c = max(1, b - a + 0); } };
+            setRange(ANIM_IDLE, idleStart, idleCount);
+            setRange(ANIM_CHASE, chaseStart, chaseCount);
+            setRange(ANIM_CHARGE, chargeStart, chargeCount);
         }
 
         if (isShooting)
@@ -1884,13 +3981,13 @@ public:
             actionTimer += dt;
             int atkStart = chargeStart + 1;
             int atkCount = chargeCount;
-            if (!metaLabels.empty())
+            if (!meta->labels.empty())
             {
-                auto it = metaLabels.find("attack");
-                if (it != metaLabels.end())
+                int a, b;
+                if (meta->labels.find(ANIM_ATTACK, a, b))
                 {
-                    atkStart = it->second.first;
-                    atkCount = max(1, it->second.second - it->second.first + 0);
+                    atkStart = a;
+                    atkCount = max(1, b - a + 0);
                 }
             }
             seqStart = atkStart;
@@ -1923,33 +4020,15 @@ public:
             animFPS = 0.6f;
         }
 
-        if (pauseTimer <= 0 && stateTimer > 2.2f && rand() % 100 < 4)
+        if (pauseTimer <= 0 && stateTimer > 2.2f && rngAI.below(100) < 4)
         {
-            velocityX = -velocityX;
+            velocityX() = -velocityX();
             stateTimer = 0;
         }
-
-        if (x < 50)
-        {
-            x = 50;
-            velocityX = fabs(velocityX);
-        }
-        if (x > SCREEN_WIDTH - getWidth() - 50)
-        {
-            x = SCREEN_WIDTH - getWidth() - 50;
-            velocityX = -fabs(velocityX);
-        }
     }
 
-    void updateSkeleton(float dt, char **map, float playerX, float playerY)
+    void updateSkeleton(float dt, float playerX, float playerY)
     {
-        if (!onGround)
-        {
-            velocityY += GRAVITY;
-            if (velocityY > TERMINAL_VELOCITY)
-                velocityY = TERMINAL_VELOCITY;
-        }
-
         float distX = fabs(getCenterX() - playerX);
         float distY = fabs(getCenterY() - playerY);
         bool canThrow = (distX < 260 && distY < 160);
@@ -1959,13 +4038,13 @@ public:
         int windupStart = max(idleCount, framesInRow / 3), windupCount = max(1, min(4, framesInRow - windupStart));
         int throwStart = windupStart + windupCount, throwCount = max(1, min(7, framesInRow - throwStart));
         int jumpStart = throwStart + throwCount, jumpCount = max(1, min(10, framesInRow - jumpStart));
-        if (!metaLabels.empty())
+        if (!meta->labels.empty())
         {
-            auto setRange = [&](const std::string &name, int &s, int &c)
-            { auto it = metaLabels.find(name); if (it!=metaLabels.end()) { s = it->second.first; c = max(1, it->second.second - it->second.first + 0); } };
-            setRange("idle", idleStart, idleCount);
+            auto setRange = [&](AnimLabel label, int &s, int &c)
+            { int a, b; if (meta->labels.find(label, a, b)) { s = a; c = max(1, b - a + 0); } };
+            setRange(ANIM_IDLE, idleStart, idleCount);
             int aS = 0, aC = 0;
-            setRange("attack", aS, aC);
+            setRange(ANIM_ATTACK, aS, aC);
             if (aC > 0)
             {
                 throwStart = aS;
@@ -1974,7 +4053,7 @@ public:
                 windupCount = min(2, aC);
             }
             int jS = 0, jC = 0;
-            setRange("jump", jS, jC);
+            setRange(ANIM_JUMP, jS, jC);
             if (jC > 0)
             {
                 jumpStart = jS;
@@ -1982,7 +4061,7 @@ public:
             }
         }
 
-        if (onGround && shootTimer >= 5.0f && canThrow)
+        if (onGround() && shootTimer >= 5.0f && canThrow)
         {
             isShooting = true;
             shootTimer = 0;
@@ -2013,702 +4092,1482 @@ public:
             }
         }
 
-        if (pauseTimer <= 0)
+        if (pauseTimer <= 0 && velocityX() == 0)
+            velocityX() = 2.0f;
+
+        if (!isShooting && (!onGround() || jumpingAcross))
+        {
+            animRow = 0;
+            seqStart = jumpStart;
+            animFrames = jumpCount;
+            animFPS = 10.0f; // MASTERCLASS: Smooth jump animation
+        }
+        else if (!isShooting && onGround())
+        {
+            animRow = 0;
+            int wS = idleStart;
+            int wC = idleCount;
+            int itWalkA, itWalkB;
+            if (meta->labels.find(ANIM_WALK, itWalkA, itWalkB))
+            {
+                wS = itWalkA;
+                wC = max(1, itWalkB - itWalkA + 0);
+            }
+            bool moving = (fabs(velocityX()) > 0.1f && pauseTimer <= 0);
+            seqStart = moving ? wS : idleStart;
+            animFrames = moving ? wC : idleCount;
+            animFPS = moving ? 8.0f : 0.6f;
+        }
+    }
+
+    void updateInvisibleMan(float dt, float playerX, float playerY)
+    {
+        // MASTERCLASS: Invisible man is ALWAYS visible (uses dim texture during teleport)
+        if (pauseTimer <= 0 && velocityX() == 0)
+            velocityX() = 2.0f;
+
+        // Teleport logic - but always keep visible (use dim texture)
+        bool startTeleport = (actionTimer > 0.8f && rngAI.below(100) < 40);
+        if (teleportCooldown <= 0 && startTeleport && !jumpingAcross)
+        {
+            teleporting = true;
+            isVisible = true; // MASTERCLASS: Keep visible
+            if (texDimPtr)
+                sprite.setTexture(*texDimPtr); // Use dim texture for "fading" effect
+            teleportTimer = 0;
+            invisibleTimer = 0;
+            pauseTimer = 0.05f;
+            velocityX() = 0;
+            animRow = 0;
+            int sS = 0, sC = 3;
+            int itSpinA, itSpinB;
+            if (meta->labels.find(ANIM_SPIN, itSpinA, itSpinB))
+            {
+                sS = itSpinA;
+                sC = max(1, itSpinB - itSpinA + 0);
+            }
+            seqStart = sS;
+            animFrames = sC;
+            animFPS = 12.0f; // MASTERCLASS: Fast spin animation
+
+            chooseReappearPosition(playerX, playerY, jumpTargetX, y());
+            jumpTargetRow = std::max(0, std::min(levelHeight - 1, (int)((y() + getHeight()) / CELL_SIZE)));
+        }
+
+        if (teleporting)
+        {
+            teleportTimer += dt;
+            invisibleTimer += dt;
+            if (teleportTimer >= 0.12f || invisibleTimer >= 0.25f)
+            {
+                float tx, ty;
+                chooseReappearPosition(playerX, playerY, tx, ty);
+                x() = tx;
+                y() = ty;
+                isVisible = true;
+                if (texPtr)
+                    sprite.setTexture(*texPtr); // Switch back to normal texture
+                teleporting = false;
+                teleportCooldown = 0.3f + rngAI.below(30) / 100.0f;
+                pauseTimer = 0.3f;
+                animRow = 0;
+                int rS = 0, rC = 3;
+                int itRecA, itRecB;
+                if (meta->labels.find(ANIM_RECOVER, itRecA, itRecB))
+                {
+                    rS = itRecA;
+                    rC = max(1, itRecB - itRecA + 0);
+                }
+                seqStart = rS;
+                animFrames = rC;
+                animFPS = 10.0f;
+                facingRight = (playerX >= x());
+            }
+        }
+
+        if (teleportCooldown > 0)
+            teleportCooldown -= dt;
+
+        // Animation selection (when not teleporting)
+        if (!teleporting)
+        {
+            animRow = 0;
+            int runS = 0;
+            int runC = max(1, rowFrameCounts[0] > 0 ? rowFrameCounts[0] : 1);
+            int itRunA, itRunB;
+            if (meta->labels.find(ANIM_RUN, itRunA, itRunB))
+            {
+                runS = itRunA;
+                runC = max(1, itRunB - itRunA + 0);
+            }
+            bool moving = (fabs(velocityX()) > 0.1f && pauseTimer <= 0);
+            seqStart = moving ? runS : (meta->labels.has(ANIM_IDLE) ? meta->labels.at(ANIM_IDLE).first : 0);
+            animFrames = moving ? runC : (meta->labels.has(ANIM_IDLE) ? max(1, meta->labels.at(ANIM_IDLE).second - meta->labels.at(ANIM_IDLE).first + 0) : 3);
+            animFPS = moving ? 10.0f : 6.0f; // MASTERCLASS: Smooth animations
+        }
+    }
+
+    void updateChelnov(float dt, float playerX, float playerY)
+    {
+        if (shootTimer >= 4.0f)
+        {
+            isShooting = true;
+            shootTimer = 0;
+            actionTimer = 0;
+            hasFired = false;
+        }
+
+        if (isShooting)
+        {
+            actionTimer += dt;
+            if (actionTimer >= 1.0f)
+            {
+                isShooting = false;
+            }
+            animRow = 2;
+            int atkS = 3, atkC = 3;
+            int a, b;
+            if (meta->rowLabels[2].find(ANIM_ATTACK_ORB, a, b))
+            {
+                atkS = a;
+                atkC = max(1, b - a + 0);
+            }
+            seqStart = atkS;
+            animFrames = atkC;
+            animFPS = 6.0f;
+        }
+
+        if (!isShooting)
+        {
+            if (pauseTimer <= 0 && velocityX() == 0)
+                velocityX() = 2.0f;
+
+            // Hop along the player's route when standing on its take-off
+            // columns; random hops only when there is no route to follow
+            int currentRow = (int)((y() + getHeight()) / CELL_SIZE);
+            if (onGround() && !jumpingAcross && jumpCooldown <= 0)
+            {
+                int footRow = (int)((y() + getHeight() + 2) / CELL_SIZE);
+                int centerCol = (int)((x() + getWidth() / 2) / CELL_SIZE);
+                const PlatformGraph::Link *route =
+                    playerFlow.route(platformGraph, platformGraph.segmentAt(footRow, centerCol));
+                bool hop = route ? (centerCol >= route->colFirst && centerCol <= route->colLast)
+                                 : rngAI.below(100) < 4;
+                if (hop && findJumpTarget(currentRow))
+                {
+                    jumpingAcross = true;
+                    velocityY() = -11.0f;
+                    jumpCooldown = 3.5f;
+                }
+            }
+
+            if (jumpingAcross)
+            {
+                if (x() < jumpTargetX)
+                    velocityX() = 0.5f;
+                else if (x() > jumpTargetX)
+                    velocityX() = -0.5f;
+
+                if (onGround())
+                {
+                    jumpingAcross = false;
+                    pauseTimer = 0.6f;
+                }
+            }
+
+            if (onGround())
+            {
+                animRow = 0;
+                int wS = 0, wC = 5;
+                int a, b;
+                if (meta->rowLabels[0].find(ANIM_WALK, a, b))
+                {
+                    wS = a;
+                    wC = max(1, b - a + 0);
+                }
+                seqStart = wS;
+                animFrames = wC;
+                animFPS = 1.2f;
+            }
+            else
+            {
+                animRow = 1;
+                int jS = 0, jC = 3;
+                int a, b;
+                if (meta->rowLabels[1].find(ANIM_JUMP, a, b))
+                {
+                    jS = a;
+                    jC = max(1, b - a + 0);
+                }
+                seqStart = jS;
+                animFrames = jC;
+                animFPS = 1.5f;
+            }
+        }
+    }
+
+    bool canBeCapture()
+    {
+        if (type == 2)
+            return isVisible;
+        if (type == 3)
+            return !isShooting;
+        return true;
+    }
+
+    bool isInVacuumRange(float px, float py, int dir, float range, float angle)
+    {
+        float dx = getCenterX() - px;
+        float dy = getCenterY() - py;
+        float dist = sqrt(dx * dx + dy * dy);
+        if (dist > range)
+            return false;
+
+        float angleToEnemy = atan2(dy, dx) * 180.0f / 3.14159f;
+        float targetAngle = (dir == 0) ? 0 : (dir == 1) ? -90
+                                         : (dir == 2)   ? 180
+                                                        : 90;
+        float angleDiff = fabs(angleToEnemy - targetAngle);
+        if (angleDiff > 180)
+            angleDiff = 360 - angleDiff;
+
+        return angleDiff < angle;
+    }
+
+    void pullTowards(float px, float py, float power)
+    {
+        float dx = px - getCenterX();
+        float dy = py - getCenterY();
+        float dist = sqrt(dx * dx + dy * dy);
+        if (dist > 5)
+        {
+            x() += (dx / dist) * power;
+            y() += (dy / dist) * power;
+        }
+    }
+
+    bool collidesWith(float px, float py, int pw, int ph)
+    {
+        return (x() < px + pw - 10 && x() + getWidth() > px + 10 &&
+                y() < py + ph - 10 && y() + getHeight() > py + 10);
+    }
+
+    float &x() { return hot->x[id]; }
+    float &y() { return hot->y[id]; }
+    float &velocityX() { return hot->velocityX[id]; }
+    float &velocityY() { return hot->velocityY[id]; }
+    unsigned char &active() { return hot->active[id]; }
+    unsigned char &captured() { return hot->captured[id]; }
+    unsigned char &onGround() { return hot->onGround[id]; }
+
+    float getCenterX() { return x() + (currW * ENEMY_SCALE) / 2; }
+    float getCenterY() { return y() + (currH * ENEMY_SCALE) / 2; }
+    int getWidth() { return (int)(currW * ENEMY_SCALE); }
+    int getHeight() { return (int)(currH * ENEMY_SCALE); }
+};
+
+// ============================================================================
+// ENEMY STORE
+// ============================================================================
+// The level's enemies: motion arrays in hot, one Enemy record per id in cold.
+// Ids are stable for the level; enemies are never removed, only deactivated.
+class EnemyStore
+{
+public:
+    EnemyMotion hot;
+
+    size_t size() const { return cold.size(); }
+    Enemy &operator[](size_t i) { return cold[i]; }
+
+    void clear()
+    {
+        hot.clear();
+        cold.clear();
+    }
+
+    // Adds an enemy at (sx, sy); skeletons may walk closer to the world edges
+    Enemy &spawn(int type, float sx, float sy)
+    {
+        int id = hot.add(sx, sy, type == 1 ? 10.0f : 50.0f);
+        cold.push_back(Enemy(hot, id, type));
+        return cold.back();
+    }
+
+private:
+    std::vector<Enemy> cold;
+};
+
+// ============================================================================
+// ENEMY PROJECTILE CLASS
+// ============================================================================
+class EnemyProjectile
+{
+public:
+    float x, y;
+    float velocityX, velocityY;
+    bool active;
+    Sprite sprite;
+    RenderLerp lerp;
+    int frames;
+    int frameIndex;
+    float animTimer;
+    float animFPS;
+    int frameW;
+    int texH;
+    bool hasTexture;
+
+    EnemyProjectile(float sx, float sy, float tx, float ty)
+    {
+        x = sx;
+        y = sy;
+        active = true;
+
+        float dx = tx - sx;
+        float dy = ty - sy;
+        float dist = sqrt(dx * dx + dy * dy);
+        if (dist > 0)
         {
-            if (velocityX == 0) velocityX = 2.0f;
-            x += velocityX * (dt * 60.0f);
+            velocityX = (dx / dist) * 5.5f;
+            velocityY = (dy / dist) * 5.5f;
         }
-        y += velocityY * (dt * 60.0f);
-        checkPlatformCollision(map);
-
-        if (!isShooting && (!onGround || jumpingAcross))
+        else
         {
-            animRow = 0;
-            seqStart = jumpStart;
-            animFrames = jumpCount;
-            animFPS = 10.0f; // MASTERCLASS: Smooth jump animation
+            velocityX = 5.5f;
+            velocityY = 0;
         }
-        else if (!isShooting && onGround)
+
+        frames = 1;
+        frameIndex = 0;
+        animTimer = 0;
+        animFPS = 8.0f;
+        frameW = 0;
+        texH = 0;
+        hasTexture = false;
+    }
+
+    void update(float dt)
+    {
+        if (!active)
+            return;
+
+        animTimer += dt;
+        if (frames > 1 && animTimer > (1.0f / animFPS))
         {
-            animRow = 0;
-            int wS = idleStart;
-            int wC = idleCount;
-            auto itWalk = metaLabels.find("walk");
-            if (itWalk != metaLabels.end())
+            animTimer = 0;
+            frameIndex = (frameIndex + 1) % frames;
+            if (hasTexture && frameW > 0 && texH > 0)
             {
-                wS = itWalk->second.first;
-                wC = max(1, itWalk->second.second - itWalk->second.first + 0);
+                sprite.setTextureRect(IntRect(frameIndex * frameW, 0, frameW, texH));
             }
-            bool moving = (fabs(velocityX) > 0.1f && pauseTimer <= 0);
-            seqStart = moving ? wS : idleStart;
-            animFrames = moving ? wC : idleCount;
-            animFPS = moving ? 8.0f : 0.6f;
         }
 
-        if (x < 10)
-        {
-            x = 10;
-            velocityX = fabs(velocityX);
-        }
-        if (x > SCREEN_WIDTH - getWidth() - 10)
+        x += velocityX;
+        y += velocityY;
+
+        if (x < -50 || x > world_width() + 50 || y < -50 || y > world_height() + 50)
         {
-            x = SCREEN_WIDTH - getWidth() - 10;
-            velocityX = -fabs(velocityX);
+            active = false;
         }
+
+        sprite.setPosition(x, y);
     }
 
-    void updateInvisibleMan(float dt, char **map, float playerX, float playerY)
+    bool collidesWith(float px, float py, int pw, int ph)
     {
-        // MASTERCLASS: Invisible man is ALWAYS visible (uses dim texture during teleport)
-        if (!onGround)
-        {
-            velocityY += GRAVITY;
-            if (velocityY > TERMINAL_VELOCITY)
-                velocityY = TERMINAL_VELOCITY;
-        }
+        return (x < px + pw && x + 16 > px && y < py + ph && y + 16 > py);
+    }
+};
 
-        if (pauseTimer <= 0)
-        {
-            if (velocityX == 0) velocityX = 2.0f;
-            x += velocityX * (dt * 60.0f);
-        }
-        y += velocityY * (dt * 60.0f);
-        checkPlatformCollision(map);
+// ============================================================================
+// PROJECTILE CLASS
+// ============================================================================
+class Projectile
+{
+public:
+    float x, y;
+    float velocityX, velocityY;
+    int enemyType;
+    bool active;
+    bool isRolling;
+    float lifetime;
+    Sprite sprite;
+    RenderLerp lerp;
+    float rotation;
+    float rotationSpeed;
+    int rollDir;
+    int dir;
+    int desiredRow;
+    bool movingToRow;
+    int spawnRow;
 
-        if (x < 50)
-        {
-            x = 50;
-            velocityX = fabs(velocityX);
-        }
-        if (x > SCREEN_WIDTH - getWidth() - 50)
-        {
-            x = SCREEN_WIDTH - getWidth() - 50;
-            velocityX = -fabs(velocityX);
-        }
+    Projectile(float sx, float sy, int dir, int type)
+    {
+        x = sx;
+        y = sy;
+        enemyType = type;
+        active = true;
+        isRolling = false;
+        lifetime = PROJECTILE_LIFETIME;
+        rotation = 0;
+        rotationSpeed = 15.0f;
+        rollDir = 0;
+        this->dir = dir;
+        spawnRow = (int)((sy + getSize()) / CELL_SIZE);
+        desiredRow = spawnRow;
+        movingToRow = false;
 
-        // Teleport logic - but always keep visible (use dim texture)
-        bool startTeleport = (actionTimer > 0.8f && rand() % 100 < 40);
-        if (teleportCooldown <= 0 && startTeleport && !jumpingAcross)
+        switch (dir)
         {
-            teleporting = true;
-            isVisible = true; // MASTERCLASS: Keep visible
-            if (texDimPtr)
-                sprite.setTexture(*texDimPtr); // Use dim texture for "fading" effect
-            teleportTimer = 0;
-            invisibleTimer = 0;
-            pauseTimer = 0.05f;
+        case 0:
+            velocityX = PROJECTILE_SPEED;
+            velocityY = 0;
+            isRolling = true;
+            y = platformTopY(spawnRow) - getSize();
+            velocityY = 0;
+            velocityX = ROLL_SPEED;
+            break;
+        case 1:
             velocityX = 0;
-            animRow = 0;
-            int sS = 0, sC = 3;
-            auto itSpin = metaLabels.find("spin");
-            if (itSpin != metaLabels.end())
+            velocityY = -PROJECTILE_SPEED;
+            desiredRow = std::max(0, spawnRow - 1);
+            movingToRow = (desiredRow != spawnRow);
+            if (!movingToRow)
             {
-                sS = itSpin->second.first;
-                sC = max(1, itSpin->second.second - itSpin->second.first + 0);
+                isRolling = true;
+                y = platformTopY(spawnRow) - getSize();
+                velocityY = 0;
+                velocityX = (rollDir != 0 ? (float)rollDir : ((rngAI.below(2) == 0) ? 1.0f : -1.0f)) * ROLL_SPEED;
             }
-            seqStart = sS;
-            animFrames = sC;
-            animFPS = 12.0f; // MASTERCLASS: Fast spin animation
-
-            chooseReappearPosition(map, playerX, playerY, jumpTargetX, y);
-            jumpTargetRow = std::max(0, std::min(LEVEL_HEIGHT - 1, (int)((y + getHeight()) / CELL_SIZE)));
-        }
-
-        if (teleporting)
-        {
-            teleportTimer += dt;
-            invisibleTimer += dt;
-            if (teleportTimer >= 0.12f || invisibleTimer >= 0.25f)
+            break;
+        case 2:
+            velocityX = -PROJECTILE_SPEED;
+            velocityY = 0;
+            isRolling = true;
+            y = platformTopY(spawnRow) - getSize();
+            velocityY = 0;
+            velocityX = -ROLL_SPEED;
+            break;
+        case 3:
+            velocityX = 0;
+            velocityY = PROJECTILE_SPEED;
+            desiredRow = std::min(levelHeight - 1, spawnRow + 1);
+            movingToRow = (desiredRow != spawnRow);
+            if (!movingToRow)
             {
-                float tx, ty;
-                chooseReappearPosition(map, playerX, playerY, tx, ty);
-                x = tx;
-                y = ty;
-                isVisible = true;
-                if (texPtr)
-                    sprite.setTexture(*texPtr); // Switch back to normal texture
-                teleporting = false;
-                teleportCooldown = 0.3f + (rand() % 30) / 100.0f;
-                pauseTimer = 0.3f;
-                animRow = 0;
-                int rS = 0, rC = 3;
-                auto itRec = metaLabels.find("recover");
-                if (itRec != metaLabels.end())
-                {
-                    rS = itRec->second.first;
-                    rC = max(1, itRec->second.second - itRec->second.first + 0);
-                }
-                seqStart = rS;
-                animFrames = rC;
-                animFPS = 10.0f;
-                facingRight = (playerX >= x);
+                isRolling = true;
+                y = platformTopY(spawnRow) - getSize();
+                velocityY = 0;
+                velocityX = (rollDir != 0 ? (float)rollDir : ((rngAI.below(2) == 0) ? 1.0f : -1.0f)) * ROLL_SPEED;
             }
+            break;
         }
+    }
 
-        if (teleportCooldown > 0)
-            teleportCooldown -= dt;
-
-        // Animation selection (when not teleporting)
-        if (!teleporting)
-        {
-            animRow = 0;
-            int runS = 0;
-            int runC = max(1, rowFrameCounts[0] > 0 ? rowFrameCounts[0] : 1);
-            auto itRun = metaLabels.find("run");
-            if (itRun != metaLabels.end())
-            {
-                runS = itRun->second.first;
-                runC = max(1, itRun->second.second - itRun->second.first + 0);
-            }
-            bool moving = (fabs(velocityX) > 0.1f && pauseTimer <= 0);
-            seqStart = moving ? runS : (metaLabels.count("idle") ? metaLabels["idle"].first : 0);
-            animFrames = moving ? runC : (metaLabels.count("idle") ? max(1, metaLabels["idle"].second - metaLabels["idle"].first + 0) : 3);
-            animFPS = moving ? 10.0f : 6.0f; // MASTERCLASS: Smooth animations
-        }
+    void setupSprite(Texture &tex)
+    {
+        sprite.setTexture(tex);
+        sprite.setScale(PROJECTILE_SCALE, PROJECTILE_SCALE);
+        sprite.setTextureRect(IntRect(0, 0, ENEMY_FRAME_WIDTH, ENEMY_FRAME_HEIGHT));
     }
 
-    void updateChelnov(float dt, char **map, float playerX, float playerY)
+    // Update movement, rolling, gravity, and platform interactions
+    void update(float dt, const TileGrid &tiles)
     {
-        if (shootTimer >= 4.0f)
+        if (!active)
+            return;
+
+        lifetime -= dt;
+        if (lifetime <= 0)
         {
-            isShooting = true;
-            shootTimer = 0;
-            actionTimer = 0;
-            hasFired = false;
+            active = false;
+            return;
         }
 
-        if (isShooting)
+        // Move vertically to target row before switching to rolling
+        if (movingToRow)
         {
-            actionTimer += dt;
-            if (actionTimer >= 1.0f)
+            y += velocityY;
+            int targetY = platformTopY(desiredRow) - getSize();
+            bool reached = (dir == 1) ? (y <= targetY) : (y >= targetY);
+            if (reached)
             {
-                isShooting = false;
+                y = targetY;
+                velocityY = 0;
+                isRolling = true;
+                movingToRow = false;
+                if (velocityX == 0)
+                    velocityX = (rollDir != 0 ? (float)rollDir : ((rngAI.below(2) == 0) ? 1.0f : -1.0f)) * ROLL_SPEED;
             }
-            animRow = 2;
-            int atkS = 3, atkC = 3;
-            if (!metaLabelsPerRow.empty())
+        }
+        // Aerial motion until first platform contact flips to rolling
+        else if (!isRolling)
+        {
+            x += velocityX;
+            y += velocityY;
+
+            int gridY = (int)((y + getSize()) / CELL_SIZE);
+            int gridX = (int)((x + getSize() / 2) / CELL_SIZE);
+
+            if (tiles.has(gridY, gridX, TILE_FLOOR))
             {
-                auto itR = metaLabelsPerRow.find(2);
-                if (itR != metaLabelsPerRow.end())
-                {
-                    auto it = itR->second.find("attack_orb");
-                    if (it != itR->second.end())
-                    {
-                        atkS = it->second.first;
-                        atkC = max(1, it->second.second - it->second.first + 0);
-                    }
-                }
+                isRolling = true;
+                y = tiles.surfaceY(gridY, gridX) - getSize();
+                velocityY = 0;
+                if (velocityX == 0)
+                    velocityX = (rollDir != 0 ? (float)rollDir : ((rngAI.below(2) == 0) ? 1.0f : -1.0f)) * ROLL_SPEED;
             }
-            seqStart = atkS;
-            animFrames = atkC;
-            animFPS = 6.0f;
         }
-
-        if (!isShooting)
+        // Rolling along platforms with light gravity to settle into slopes
+        else
         {
-            if (!onGround)
-            {
-                velocityY += GRAVITY;
-                if (velocityY > TERMINAL_VELOCITY)
-                    velocityY = TERMINAL_VELOCITY;
-            }
+            x += velocityX;
+            velocityY += GRAVITY * 0.5f;
+            y += velocityY;
 
-            if (pauseTimer <= 0)
-            {
-                if (velocityX == 0) velocityX = 2.0f;
-                x += velocityX * (dt * 60.0f);
-            }
-            y += velocityY * (dt * 60.0f);
-            checkPlatformCollision(map);
+            int gridY = (int)((y + getSize()) / CELL_SIZE);
+            int gridX = (int)((x + getSize() / 2) / CELL_SIZE);
 
-            int currentRow = (int)((y + getHeight()) / CELL_SIZE);
-            if (onGround && !jumpingAcross && jumpCooldown <= 0 && rand() % 100 < 4)
+            if (tiles.has(gridY, gridX, TILE_FLOOR))
             {
-                if (findJumpTarget(map, currentRow))
-                {
-                    jumpingAcross = true;
-                    velocityY = -11.0f;
-                    jumpCooldown = 3.5f;
-                }
+                y = tiles.surfaceY(gridY, gridX) - getSize();
+                velocityY = 0;
             }
 
-            if (jumpingAcross)
+            // Bounce at screen edges to keep activity within bounds
+            if (x < 10)
             {
-                if (x < jumpTargetX)
-                    velocityX = 0.5f;
-                else if (x > jumpTargetX)
-                    velocityX = -0.5f;
-
-                if (onGround)
-                {
-                    jumpingAcross = false;
-                    pauseTimer = 0.6f;
-                }
+                x = 10;
+                velocityX = ROLL_SPEED;
             }
-
-            if (onGround)
+            if (x > world_width() - getSize() - 10)
             {
-                animRow = 0;
-                int wS = 0, wC = 5;
-                if (!metaLabelsPerRow.empty())
-                {
-                    auto itR = metaLabelsPerRow.find(0);
-                    if (itR != metaLabelsPerRow.end())
-                    {
-                        auto it = itR->second.find("walk");
-                        if (it != itR->second.end())
-                        {
-                            wS = it->second.first;
-                            wC = max(1, it->second.second - it->second.first + 0);
-                        }
-                    }
-                }
-                seqStart = wS;
-                animFrames = wC;
-                animFPS = 1.2f;
+                x = world_width() - getSize() - 10;
+                velocityX = -ROLL_SPEED;
             }
-            else
+            if (y > world_height() - getSize())
             {
-                animRow = 1;
-                int jS = 0, jC = 3;
-                if (!metaLabelsPerRow.empty())
-                {
-                    auto itR = metaLabelsPerRow.find(1);
-                    if (itR != metaLabelsPerRow.end())
-                    {
-                        auto it = itR->second.find("jump");
-                        if (it != itR->second.end())
-                        {
-                            jS = it->second.first;
-                            jC = max(1, it->second.second - it->second.first + 0);
-                        }
-                    }
-                }
-                seqStart = jS;
-                animFrames = jC;
-                animFPS = 1.5f;
+                y = world_height() - getSize();
+                velocityY = 0;
             }
         }
 
-        if (x < 50)
-        {
-            x = 50;
-            velocityX = fabs(velocityX);
-        }
-        if (x > SCREEN_WIDTH - getWidth() - 50)
-        {
-            x = SCREEN_WIDTH - getWidth() - 50;
-            velocityX = -fabs(velocityX);
-        }
+        // Spin animations faster while rolling; place sprite at center of bounding box
+        rotation += (isRolling ? fabs(velocityX) * 1.2f : rotationSpeed);
+        sprite.setPosition(x, y);
+        // strict compliance: no rotation, use pre-baked spin frames
     }
 
-    void checkPlatformCollision(char **map)
+    bool collidesWith(Enemy &enemy)
     {
-        onGround = false;
+        if (!active || !enemy.active() || enemy.captured())
+            return false;
+        return (x < enemy.x() + enemy.getWidth() - 10 && x + getSize() > enemy.x() + 10 &&
+                y < enemy.y() + enemy.getHeight() - 10 && y + getSize() > enemy.y() + 10);
+    }
 
-        int baseRow = (int)((y + getHeight() + 2) / CELL_SIZE);
-        int leftX = (int)((x + 5) / CELL_SIZE);
-        int rightX = (int)((x + getWidth() - 5) / CELL_SIZE);
-        int centerX = (int)((x + getWidth() / 2) / CELL_SIZE);
+    bool isAerial() { return !isRolling; }
+    int getSize() { return (int)(ENEMY_FRAME_WIDTH * 0.7f); }
+};
 
-        auto isSolidAtRow = [&](int row)
-        {
-            if (row < 0 || row >= LEVEL_HEIGHT)
-                return false;
-            bool coll = false;
-            if (leftX >= 0 && leftX < LEVEL_WIDTH && (map[row][leftX] == '#' || map[row][leftX] == '/' || map[row][leftX] == '\\' || map[row][leftX] == 'S'))
-                coll = true;
-            if (centerX >= 0 && centerX < LEVEL_WIDTH && (map[row][centerX] == '#' || map[row][centerX] == '/' || map[row][centerX] == '\\' || map[row][centerX] == 'S'))
-                coll = true;
-            if (rightX >= 0 && rightX < LEVEL_WIDTH && (map[row][rightX] == '#' || map[row][rightX] == '/' || map[row][rightX] == '\\' || map[row][rightX] == 'S'))
-                coll = true;
-            return coll;
-        };
+// ============================================================================
+// PROFILER
+// ============================================================================
+// CPU time per subsystem. Sections accumulate over a frame (the fixed-step
+// loop may enter update sections several times) and endFrame() pushes each
+// total into a rolling history for the min/avg/p99 overlay. With tracing on,
+// every begin/end pair is also kept as a Chrome trace event.
+enum ProfileSection
+{
+    PROF_FRAME,
+    PROF_UPDATE,
+    PROF_PLAYER,
+    PROF_ENEMIES,
+    PROF_SEPARATION,
+    PROF_ENEMY_SHOTS,
+    PROF_PROJECTILES,
+    PROF_POWERUPS,
+    PROF_EFFECTS,
+    PROF_RENDER,
+    PROF_LEVEL,
+    PROF_RAMPS,
+    PROF_ENTITIES,
+    PROF_HUD,   // queueing the HUD into the batch
+    PROF_FLUSH, // spriteBatch.end(): the actual draw calls for every layer
+    PROF_SECTION_COUNT
+};
 
-        int hitRow = -1;
-        if (isSolidAtRow(baseRow))
-            hitRow = baseRow;
-        else if (isSolidAtRow(baseRow + 1))
-            hitRow = baseRow + 1;
-        else if (isSolidAtRow(baseRow - 1))
-            hitRow = baseRow - 1;
+class Profiler
+{
+public:
+    static const int HISTORY = 240; // frames kept for the rolling stats
 
-        if (hitRow != -1 && velocityY >= 0)
+    struct Stats
+    {
+        float min, avg, p99; // milliseconds
+    };
+
+    Profiler() : frames(0), tracing(false)
+    {
+        for (int s = 0; s < PROF_SECTION_COUNT; s++)
         {
-            y = platformTopYAt(hitRow, centerX) - getHeight();
-            velocityY = 0;
-            onGround = true;
+            open[s] = 0;
+            accum[s] = 0;
+            for (int f = 0; f < HISTORY; f++)
+                history[s][f] = 0;
         }
+    }
+
+    static const char *name(int section)
+    {
+        static const char *names[PROF_SECTION_COUNT] = {
+            "frame", "update", "player", "enemies", "separation", "enemy_shots",
+            "projectiles", "powerups", "effects", "render", "display_level",
+            "ramps", "entities", "hud", "flush"};
+        return names[section];
+    }
+
+    void begin(int section) { open[section] = clock.getElapsedTime().asMicroseconds(); }
+
+    void end(int section)
+    {
+        Int64 duration = clock.getElapsedTime().asMicroseconds() - open[section];
+        accum[section] += duration;
+        if (tracing && events.size() < MAX_TRACE_EVENTS)
+            events.push_back(TraceEvent{section, open[section], duration});
+    }
 
-        if (y > SCREEN_HEIGHT - getHeight())
+    void endFrame()
+    {
+        for (int s = 0; s < PROF_SECTION_COUNT; s++)
         {
-            y = SCREEN_HEIGHT - getHeight();
-            velocityY = 0;
-            onGround = true;
+            history[s][frames % HISTORY] = accum[s] / 1000.0f;
+            accum[s] = 0;
         }
+        frames++;
     }
 
-    bool canBeCapture()
+    Stats stats(int section) const
     {
-        if (type == 2)
-            return isVisible;
-        if (type == 3)
-            return !isShooting;
-        return true;
+        Stats st = {0, 0, 0};
+        int n = std::min(frames, HISTORY);
+        if (n == 0)
+            return st;
+        std::vector<float> samples(history[section], history[section] + n);
+        std::sort(samples.begin(), samples.end());
+        float sum = 0;
+        for (int i = 0; i < n; i++)
+            sum += samples[i];
+        st.min = samples[0];
+        st.avg = sum / n;
+        st.p99 = samples[std::min(n - 1, (int)(n * 0.99f))];
+        return st;
     }
 
-    bool isInVacuumRange(float px, float py, int dir, float range, float angle)
+    void setTracing(bool on) { tracing = on; }
+
+    // Writes the recorded events in the Chrome trace format (chrome://tracing,
+    // Perfetto). Nested sections show up as nested slices on one track.
+    bool exportChromeTrace(const std::string &path) const
     {
-        float dx = getCenterX() - px;
-        float dy = getCenterY() - py;
-        float dist = sqrt(dx * dx + dy * dy);
-        if (dist > range)
+        std::ofstream out(path.c_str());
+        if (!out)
             return false;
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        for (size_t i = 0; i < events.size(); i++)
+        {
+            const TraceEvent &e = events[i];
+            out << (i ? ",\n" : "\n") << "{\"name\":\"" << name(e.section)
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << e.start
+                << ",\"dur\":" << e.duration << "}";
+        }
+        out << "\n]}\n";
+        return (bool)out;
+    }
 
-        float angleToEnemy = atan2(dy, dx) * 180.0f / 3.14159f;
-        float targetAngle = (dir == 0) ? 0 : (dir == 1) ? -90
-                                         : (dir == 2)   ? 180
-                                                        : 90;
-        float angleDiff = fabs(angleToEnemy - targetAngle);
-        if (angleDiff > 180)
-            angleDiff = 360 - angleDiff;
+    size_t traceEventCount() const { return events.size(); }
 
-        return angleDiff < angle;
+private:
+    static const size_t MAX_TRACE_EVENTS = 1 << 20;
+
+    struct TraceEvent
+    {
+        int section;
+        Int64 start;
+        Int64 duration;
+    };
+
+    Clock clock;
+    Int64 open[PROF_SECTION_COUNT];
+    Int64 accum[PROF_SECTION_COUNT];
+    float history[PROF_SECTION_COUNT][HISTORY];
+    int frames;
+    bool tracing;
+    std::vector<TraceEvent> events;
+};
+
+// Times one section until it goes out of scope. next() closes the current
+// section and opens another, for long functions that run stages in sequence.
+class ProfileScope
+{
+public:
+    ProfileScope(Profiler &p, int s) : profiler(p), section(s) { profiler.begin(section); }
+    ~ProfileScope() { stop(); }
+
+    void next(int s)
+    {
+        stop();
+        section = s;
+        profiler.begin(section);
     }
 
-    void pullTowards(float px, float py, float power)
+    void stop()
     {
-        float dx = px - getCenterX();
-        float dy = py - getCenterY();
-        float dist = sqrt(dx * dx + dy * dy);
-        if (dist > 5)
+        if (section >= 0)
+            profiler.end(section);
+        section = -1;
+    }
+
+private:
+    Profiler &profiler;
+    int section;
+};
+
+// ============================================================================
+// DENSE POOL
+// ============================================================================
+// Fixed-capacity, contiguous storage for short-lived entities. Entities despawn
+// by clearing their active flag and compact() squeezes the dead ones out in one
+// stable pass per tick. Order is kept on purpose: it is the draw order of the
+// effects and the order collisions are resolved in, so a swap-remove pool would
+// change what the player sees and which shot claims a hit. The storage never
+// reallocates: once a pool is full, spawn() drops the new entity (it lands in
+// an inactive scratch slot) rather than evicting one that is still in flight.
+// The first drop per pool is logged; callers that consume game state to spawn
+// (released captures) check room() first.
+template <typename T>
+class DensePool
+{
+public:
+    DensePool() : cap(0), drops(0), label("pool") {}
+
+    void reserve(size_t n, const char *name)
+    {
+        cap = n;
+        label = name;
+        items.reserve(n);
+    }
+
+    T &spawn(T &&item)
+    {
+        if (items.size() >= cap)
         {
-            x += (dx / dist) * power;
-            y += (dy / dist) * power;
+            if (drops++ == 0)
+                LOG_WARN("[WARN] " << label << " pool full (" << cap << "), dropping new spawns");
+            overflow.clear();
+            overflow.push_back(std::move(item));
+            overflow.back().active = false;
+            return overflow.back();
         }
+        items.push_back(std::move(item));
+        return items.back();
     }
 
-    bool collidesWith(float px, float py, int pw, int ph)
+    void compact()
     {
-        return (x < px + pw - 10 && x + getWidth() > px + 10 &&
-                y < py + ph - 10 && y + getHeight() > py + 10);
+        items.erase(std::remove_if(items.begin(), items.end(),
+                                   [](const T &t)
+                                   { return !t.active; }),
+                    items.end());
     }
 
-    float getCenterX() { return x + (currW * ENEMY_SCALE) / 2; }
-    float getCenterY() { return y + (currH * ENEMY_SCALE) / 2; }
-    int getWidth() { return (int)(currW * ENEMY_SCALE); }
-    int getHeight() { return (int)(currH * ENEMY_SCALE); }
+    void clear() { items.clear(); }
+    size_t size() const { return items.size(); }
+    size_t capacity() const { return cap; }
+    size_t room() const { return cap - items.size(); }
+    int dropped() const { return drops; }
+    T &operator[](size_t i) { return items[i]; }
+    const T &operator[](size_t i) const { return items[i]; }
+
+private:
+    std::vector<T> items;
+    std::vector<T> overflow; // holds the last dropped spawn, never iterated
+    size_t cap;
+    int drops;
+    const char *label;
 };
 
 // ============================================================================
-// ENEMY PROJECTILE CLASS
+// SPATIAL GRID
 // ============================================================================
-class EnemyProjectile
+// Broad-phase buckets on the CELL_SIZE tile grid. Entities are inserted by
+// bounding box each tick; boxes outside the level clamp to the border cells.
+// query() returns candidate indices in ascending order so callers visit them in
+// the same order a full scan would.
+class SpatialGrid
 {
 public:
-    float x, y;
-    float velocityX, velocityY;
-    bool active;
-    Sprite sprite;
-    int frames;
-    int frameIndex;
-    float animTimer;
-    float animFPS;
-    int frameW;
-    int texH;
-    bool hasTexture;
+    SpatialGrid() { resize(DEFAULT_LEVEL_WIDTH, DEFAULT_LEVEL_HEIGHT); }
+
+    // Matches the grid to the level's size in cells; drops every bucket
+    void resize(int levelCols, int levelRows)
+    {
+        cols = levelCols;
+        rows = levelRows;
+        buckets.assign((size_t)cols * rows, std::vector<int>());
+    }
+
+    void clear()
+    {
+        for (size_t i = 0; i < buckets.size(); i++)
+            buckets[i].clear();
+    }
+
+    void insert(int id, const FloatRect &box)
+    {
+        int c0, c1, r0, r1;
+        cellRange(box, c0, c1, r0, r1);
+        for (int r = r0; r <= r1; r++)
+            for (int c = c0; c <= c1; c++)
+                buckets[r * cols + c].push_back(id);
+    }
+
+    void query(const FloatRect &box, std::vector<int> &out) const
+    {
+        out.clear();
+        int c0, c1, r0, r1;
+        cellRange(box, c0, c1, r0, r1);
+        for (int r = r0; r <= r1; r++)
+            for (int c = c0; c <= c1; c++)
+                out.insert(out.end(), buckets[r * cols + c].begin(), buckets[r * cols + c].end());
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+
+private:
+    void cellRange(const FloatRect &box, int &c0, int &c1, int &r0, int &r1) const
+    {
+        c0 = clampCell((int)std::floor(box.left / CELL_SIZE), cols);
+        c1 = clampCell((int)std::floor((box.left + box.width) / CELL_SIZE), cols);
+        r0 = clampCell((int)std::floor(box.top / CELL_SIZE), rows);
+        r1 = clampCell((int)std::floor((box.top + box.height) / CELL_SIZE), rows);
+    }
+
+    static int clampCell(int v, int n)
+    {
+        return v < 0 ? 0 : (v >= n ? n - 1 : v);
+    }
+
+    int cols, rows;
+    std::vector<std::vector<int>> buckets;
+};
+
+// ============================================================================
+// LEVEL DATA
+// ============================================================================
+// Levels live in Data/Levels/level<N>.txt (authoring) or level<N>.lvb
+// (compiled). The binary form is a fixed header followed by flat arrays of
+// fixed-size records, so it loads with a single read and could be mapped as
+// is (little-endian). Text format, one directive per line, '#' comments:
+//   background <1|2>          music <path>          capacity <n>
+//   map ... end               one line per row, '.' empty, '#' block,
+//                             '/' '\' ramp; the row count and longest row
+//                             set the level size (default 18x14)
+//   slope <row> <col> <px>    surface offset for a hand-placed ramp tile,
+//                             after the map
+//   ramps random              attach 1-4 random ramps at build time
+//   bombs <red|blue>          sheet for Chelnov's bombs (default red)
+//   spawn <row> <c0> <c1> <count> <type>[,<type>...]   initial enemies
+//   wave_segment <row> <c0> <c1>                        where waves land
+//   wave <type> <count>       spawned when the screen is clear, in order
+//   powerup <speed|range|power|life> <x> <row>
+// Spawn, segment and powerup rows/columns must lie inside the map (c0 <= c1);
+// text levels drop records that do not, compiled levels are rejected.
+struct LevelData
+{
+    static const int MAX_SEGMENT_TYPES = 4;
+
+    struct Segment
+    {
+        int32_t row, colStart, colEnd, count;
+        int32_t typeCount;
+        int32_t types[MAX_SEGMENT_TYPES];
+    };
+
+    struct Wave
+    {
+        int32_t type, count;
+    };
+
+    struct PowerupSpawn
+    {
+        int32_t type, x, row;
+    };
+
+    TileMap map;
+    int background;
+    int capacity;
+    bool randomRamps;
+    bool blueBombs;
+    std::string music;
+    std::vector<Segment> spawns;
+    std::vector<Segment> waveSegments;
+    std::vector<Wave> waves;
+    std::vector<PowerupSpawn> powerups;
+
+    LevelData() { clear(); }
+
+    void clear()
+    {
+        map.resize(DEFAULT_LEVEL_WIDTH, DEFAULT_LEVEL_HEIGHT);
+        background = 1;
+        capacity = 3;
+        randomRamps = false;
+        blueBombs = false;
+        music.clear();
+        spawns.clear();
+        waveSegments.clear();
+        waves.clear();
+        powerups.clear();
+    }
+
+    bool loadText(const std::string &path)
+    {
+        std::ifstream in(path.c_str());
+        if (!in)
+            return false;
+        clear();
+        std::string line;
+        int lineNo = 0;
+        bool inMap = false;
+        std::vector<std::string> mapRows;
+        while (std::getline(in, line))
+        {
+            lineNo++;
+            if (!line.empty() && line[line.size() - 1] == '\r')
+                line.erase(line.size() - 1);
+            if (inMap)
+            {
+                if (line.compare(0, 3, "end") == 0)
+                {
+                    inMap = false;
+                    setMap(mapRows);
+                }
+                else
+                    mapRows.push_back(line);
+                continue;
+            }
+
+            size_t hash = line.find('#');
+            if (hash != std::string::npos)
+                line = line.substr(0, hash);
+            std::istringstream ss(line);
+            std::string key;
+            if (!(ss >> key))
+                continue;
+
+            bool ok = true;
+            if (key == "map")
+            {
+                inMap = true;
+                mapRows.clear();
+            }
+            else if (key == "background")
+                ok = (bool)(ss >> background);
+            else if (key == "capacity")
+                ok = (bool)(ss >> capacity);
+            else if (key == "music")
+                ok = (bool)(ss >> music);
+            else if (key == "ramps")
+            {
+                std::string mode;
+                ok = (ss >> mode) && mode == "random";
+                randomRamps = ok;
+            }
+            else if (key == "bombs")
+            {
+                std::string sheet;
+                ok = (ss >> sheet) && (sheet == "red" || sheet == "blue");
+                if (ok)
+                    blueBombs = sheet == "blue";
+            }
+            else if (key == "slope")
+            {
+                int r, c, px;
+                ok = (ss >> r >> c >> px) && map.inside(r, c);
+                if (ok)
+                    map.slopeAt(r, c) = px;
+            }
+            else if (key == "spawn" || key == "wave_segment")
+            {
+                Segment seg = Segment();
+                ok = (bool)(ss >> seg.row >> seg.colStart >> seg.colEnd);
+                if (ok && key == "spawn")
+                {
+                    std::string types;
+                    ok = (ss >> seg.count >> types) && seg.count >= 0 && parseTypes(types, seg);
+                }
+                if (ok)
+                    (key == "spawn" ? spawns : waveSegments).push_back(seg);
+            }
+            else if (key == "wave")
+            {
+                Wave w;
+                ok = (ss >> w.type >> w.count) && validEnemyType(w.type) && w.count >= 0;
+                if (ok)
+                    waves.push_back(w);
+            }
+            else if (key == "powerup")
+            {
+                std::string name;
+                PowerupSpawn p;
+                ok = (ss >> name >> p.x >> p.row) && powerupFromName(name, p.type);
+                if (ok)
+                    powerups.push_back(p);
+            }
+            else
+                ok = false;
+
+            if (!ok)
+                LOG_WARN("[WARN] " << path << ":" << lineNo << ": bad level directive '" << key << "'");
+        }
+        if (inMap)
+            setMap(mapRows); // tolerate a missing "end"
+        dropOutOfBounds(path);
+        return true;
+    }
+
+    bool saveBinary(const std::string &path) const
+    {
+        std::ofstream out(path.c_str(), std::ios::binary);
+        if (!out)
+            return false;
+        BinaryHeader h = BinaryHeader();
+        std::memcpy(h.magic, "TPLV", 4);
+        h.version = BINARY_VERSION;
+        h.width = map.width;
+        h.height = map.height;
+        h.background = background;
+        h.capacity = capacity;
+        h.randomRamps = randomRamps ? 1 : 0;
+        h.blueBombs = blueBombs ? 1 : 0;
+        h.spawnCount = (int32_t)spawns.size();
+        h.waveSegmentCount = (int32_t)waveSegments.size();
+        h.waveCount = (int32_t)waves.size();
+        h.powerupCount = (int32_t)powerups.size();
+        music.copy(h.music, sizeof(h.music) - 1);
+        out.write((const char *)&h, sizeof(h));
+        writeArray(out, map.cells);
+        writeArray(out, map.slope);
+        writeArray(out, spawns);
+        writeArray(out, waveSegments);
+        writeArray(out, waves);
+        writeArray(out, powerups);
+        return (bool)out;
+    }
+
+    bool loadBinary(const std::string &path)
+    {
+        std::ifstream in(path.c_str(), std::ios::binary | std::ios::ate);
+        if (!in)
+            return false;
+        std::vector<char> blob((size_t)in.tellg());
+        in.seekg(0);
+        if (blob.size() < sizeof(BinaryHeader) || !in.read(blob.data(), blob.size()))
+            return false;
+
+        BinaryHeader h;
+        std::memcpy(&h, blob.data(), sizeof(h));
+        if (std::memcmp(h.magic, "TPLV", 4) != 0 || h.version != BINARY_VERSION ||
+            h.width <= 0 || h.height <= 0 || h.width > MAX_SIDE || h.height > MAX_SIDE)
+            return false;
+        int32_t counts[4] = {h.spawnCount, h.waveSegmentCount, h.waveCount, h.powerupCount};
+        for (int i = 0; i < 4; i++)
+            if (counts[i] < 0 || counts[i] > MAX_RECORDS)
+                return false;
+        uint64_t cells = (uint64_t)h.width * h.height;
+        uint64_t need = sizeof(h) + cells * (sizeof(char) + sizeof(int32_t)) +
+                        ((uint64_t)h.spawnCount + h.waveSegmentCount) * sizeof(Segment) +
+                        (uint64_t)h.waveCount * sizeof(Wave) + (uint64_t)h.powerupCount * sizeof(PowerupSpawn);
+        if (blob.size() < need)
+            return false;
 
-    EnemyProjectile(float sx, float sy, float tx, float ty)
+        clear();
+        background = h.background;
+        capacity = h.capacity;
+        randomRamps = h.randomRamps != 0;
+        blueBombs = h.blueBombs != 0;
+        h.music[sizeof(h.music) - 1] = '\0';
+        music = h.music;
+        const char *p = blob.data() + sizeof(h);
+        map.resize(h.width, h.height);
+        readArray(p, (int32_t)cells, map.cells);
+        readArray(p, (int32_t)cells, map.slope);
+        readArray(p, h.spawnCount, spawns);
+        readArray(p, h.waveSegmentCount, waveSegments);
+        readArray(p, h.waveCount, waves);
+        readArray(p, h.powerupCount, powerups);
+        if (!validRecords())
+        {
+            clear();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static const int32_t BINARY_VERSION = 2;
+    static const int32_t MAX_SIDE = 4096;     // cells; rejects corrupt headers before allocating
+    static const int32_t MAX_RECORDS = 65536; // per record array, same reason
+    static const int32_t ENEMY_TYPES = 4;     // ghost, skeleton, invisible man, Chelnov
+
+    // Sizes the map from the rows of a map block and fills it; ragged rows
+    // are padded with empty cells
+    void setMap(const std::vector<std::string> &rows)
     {
-        x = sx;
-        y = sy;
-        active = true;
+        if (rows.empty())
+            return;
+        size_t width = 0;
+        for (size_t r = 0; r < rows.size(); r++)
+            width = std::max(width, rows[r].size());
+        map.resize((int)std::max<size_t>(width, 1), (int)rows.size());
+        for (size_t r = 0; r < rows.size(); r++)
+            for (size_t c = 0; c < rows[r].size(); c++)
+                map.at((int)r, (int)c) = (rows[r][c] == '.') ? ' ' : rows[r][c];
+    }
 
-        float dx = tx - sx;
-        float dy = ty - sy;
-        float dist = sqrt(dx * dx + dy * dy);
-        if (dist > 0)
+    struct BinaryHeader
+    {
+        char magic[4];
+        int32_t version;
+        int32_t width, height;
+        int32_t background, capacity, randomRamps, blueBombs;
+        int32_t spawnCount, waveSegmentCount, waveCount, powerupCount;
+        char music[128];
+    };
+
+    static bool parseTypes(const std::string &list, Segment &seg)
+    {
+        std::istringstream ss(list);
+        std::string item;
+        seg.typeCount = 0;
+        while (std::getline(ss, item, ',') && seg.typeCount < MAX_SEGMENT_TYPES)
         {
-            velocityX = (dx / dist) * 5.5f;
-            velocityY = (dy / dist) * 5.5f;
+            seg.types[seg.typeCount] = atoi(item.c_str());
+            if (!validEnemyType(seg.types[seg.typeCount++]))
+                return false;
         }
-        else
+        return seg.typeCount > 0;
+    }
+
+    static bool validEnemyType(int32_t type) { return type >= 0 && type < ENEMY_TYPES; }
+
+    // Record checks for data read straight from a .lvb; the text parser
+    // applies the same rules per directive
+    bool validRecords() const
+    {
+        const std::vector<Segment> *lists[2] = {&spawns, &waveSegments};
+        for (int l = 0; l < 2; l++)
         {
-            velocityX = 5.5f;
-            velocityY = 0;
+            for (size_t i = 0; i < lists[l]->size(); i++)
+            {
+                const Segment &seg = (*lists[l])[i];
+                if (seg.typeCount < 0 || seg.typeCount > MAX_SEGMENT_TYPES || seg.count < 0 ||
+                    !segmentInBounds(seg))
+                    return false;
+                for (int t = 0; t < seg.typeCount; t++)
+                    if (!validEnemyType(seg.types[t]))
+                        return false;
+            }
         }
+        for (size_t i = 0; i < waves.size(); i++)
+            if (!validEnemyType(waves[i].type) || waves[i].count < 0)
+                return false;
+        for (size_t i = 0; i < powerups.size(); i++)
+            if (powerups[i].type < POWERUP_SPEED || powerups[i].type > POWERUP_LIFE ||
+                !powerupInBounds(powerups[i]))
+                return false;
+        return true;
+    }
 
-        frames = 1;
-        frameIndex = 0;
-        animTimer = 0;
-        animFPS = 8.0f;
-        frameW = 0;
-        texH = 0;
-        hasTexture = false;
+    bool segmentInBounds(const Segment &seg) const
+    {
+        return seg.row >= 0 && seg.row < map.height && seg.colStart >= 0 &&
+               seg.colStart <= seg.colEnd && seg.colEnd < map.width;
     }
 
-    void update(float dt)
+    bool powerupInBounds(const PowerupSpawn &p) const
     {
-        if (!active)
-            return;
+        return p.row >= 0 && p.row < map.height && p.x >= 0 && p.x < map.width * CELL_SIZE;
+    }
 
-        animTimer += dt;
-        if (frames > 1 && animTimer > (1.0f / animFPS))
+    // Text levels may name records before the map block, so bounds are checked
+    // once the whole file is read; offending records are dropped with a warning
+    void dropOutOfBounds(const std::string &path)
+    {
+        std::vector<Segment> *lists[2] = {&spawns, &waveSegments};
+        const char *names[2] = {"spawn", "wave_segment"};
+        for (int l = 0; l < 2; l++)
         {
-            animTimer = 0;
-            frameIndex = (frameIndex + 1) % frames;
-            if (hasTexture && frameW > 0 && texH > 0)
+            std::vector<Segment> &list = *lists[l];
+            size_t kept = 0;
+            for (size_t i = 0; i < list.size(); i++)
             {
-                sprite.setTextureRect(IntRect(frameIndex * frameW, 0, frameW, texH));
+                if (segmentInBounds(list[i]))
+                    list[kept++] = list[i];
+                else
+                    LOG_WARN("[WARN] " << path << ": " << names[l] << " " << list[i].row << " " << list[i].colStart
+                                       << " " << list[i].colEnd << " lies outside the " << map.width << "x"
+                                       << map.height << " map, dropped");
             }
+            list.resize(kept);
         }
+        size_t kept = 0;
+        for (size_t i = 0; i < powerups.size(); i++)
+        {
+            if (powerupInBounds(powerups[i]))
+                powerups[kept++] = powerups[i];
+            else
+                LOG_WARN("[WARN] " << path << ": powerup at x " << powerups[i].x << " row " << powerups[i].row
+                                   << " lies outside the map, dropped");
+        }
+        powerups.resize(kept);
+    }
 
-        x += velocityX;
-        y += velocityY;
-
-        if (x < -50 || x > SCREEN_WIDTH + 50 || y < -50 || y > SCREEN_HEIGHT + 50)
+    static bool powerupFromName(const std::string &name, int32_t &type)
+    {
+        static const char *names[] = {"speed", "range", "power", "life"};
+        for (int i = 0; i < 4; i++)
         {
-            active = false;
+            if (name == names[i])
+            {
+                type = i;
+                return true;
+            }
         }
+        return false;
+    }
 
-        sprite.setPosition(x, y);
+    template <typename T>
+    static void writeArray(std::ofstream &out, const std::vector<T> &v)
+    {
+        if (!v.empty())
+            out.write((const char *)v.data(), v.size() * sizeof(T));
     }
 
-    bool collidesWith(float px, float py, int pw, int ph)
+    template <typename T>
+    static void readArray(const char *&p, int32_t count, std::vector<T> &v)
     {
-        return (x < px + pw && x + 16 > px && y < py + ph && y + 16 > py);
+        v.resize(count);
+        if (count > 0)
+            std::memcpy(v.data(), p, count * sizeof(T));
+        p += count * sizeof(T);
     }
 };
 
-// ============================================================================
-// PROJECTILE CLASS
-// ============================================================================
-class Projectile
+static std::string level_path(const std::string &dir, int n, const char *ext)
 {
-public:
-    float x, y;
-    float velocityX, velocityY;
-    int enemyType;
-    bool active;
-    bool isRolling;
-    float lifetime;
-    Sprite sprite;
-    float rotation;
-    float rotationSpeed;
-    int rollDir;
-    int dir;
-    int desiredRow;
-    bool movingToRow;
-    int spawnRow;
+    return dir + "/level" + to_string(n) + ext;
+}
 
-    Projectile(float sx, float sy, int dir, int type)
-    {
-        x = sx;
-        y = sy;
-        enemyType = type;
-        active = true;
-        isRolling = false;
-        lifetime = PROJECTILE_LIFETIME;
-        rotation = 0;
-        rotationSpeed = 15.0f;
-        rollDir = 0;
-        this->dir = dir;
-        spawnRow = (int)((sy + getSize()) / CELL_SIZE);
-        desiredRow = spawnRow;
-        movingToRow = false;
+// Modification time of path, or -1 if it cannot be read
+static long long file_mtime(const std::string &path)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return -1;
+    return (long long)st.st_mtime;
+}
 
-        switch (dir)
-        {
-        case 0:
-            velocityX = PROJECTILE_SPEED;
-            velocityY = 0;
-            isRolling = true;
-            y = platformTopY(spawnRow) - getSize();
-            velocityY = 0;
-            velocityX = ROLL_SPEED;
-            break;
-        case 1:
-            velocityX = 0;
-            velocityY = -PROJECTILE_SPEED;
-            desiredRow = std::max(0, spawnRow - 1);
-            movingToRow = (desiredRow != spawnRow);
-            if (!movingToRow)
-            {
-                isRolling = true;
-                y = platformTopY(spawnRow) - getSize();
-                velocityY = 0;
-                velocityX = (rollDir != 0 ? (float)rollDir : ((rand() % 2 == 0) ? 1.0f : -1.0f)) * ROLL_SPEED;
-            }
-            break;
-        case 2:
-            velocityX = -PROJECTILE_SPEED;
-            velocityY = 0;
-            isRolling = true;
-            y = platformTopY(spawnRow) - getSize();
-            velocityY = 0;
-            velocityX = -ROLL_SPEED;
+// Reads level1, level2, ... until one is missing; compiled files win over text
+// unless the text was edited after the .lvb was written
+static std::vector<LevelData> load_levels(const std::string &dir)
+{
+    std::vector<LevelData> levels;
+    for (int n = 1;; n++)
+    {
+        LevelData level;
+        std::string lvb = level_path(dir, n, ".lvb");
+        long long lvbTime = file_mtime(lvb);
+        bool stale = lvbTime >= 0 && file_mtime(level_path(dir, n, ".txt")) > lvbTime;
+        if (stale)
+            LOG_WARN("[WARN] " << lvb << " is older than its .txt; loading the text (rerun --compile-levels)");
+        if (!stale && level.loadBinary(lvb))
+            LOG_INFO("[OK] " << level_path(dir, n, ".lvb"));
+        else if (level.loadText(level_path(dir, n, ".txt")))
+            LOG_INFO("[OK] " << level_path(dir, n, ".txt"));
+        else
             break;
-        case 3:
-            velocityX = 0;
-            velocityY = PROJECTILE_SPEED;
-            desiredRow = std::min(LEVEL_HEIGHT - 1, spawnRow + 1);
-            movingToRow = (desiredRow != spawnRow);
-            if (!movingToRow)
-            {
-                isRolling = true;
-                y = platformTopY(spawnRow) - getSize();
-                velocityY = 0;
-                velocityX = (rollDir != 0 ? (float)rollDir : ((rand() % 2 == 0) ? 1.0f : -1.0f)) * ROLL_SPEED;
-            }
+        levels.push_back(level);
+    }
+    return levels;
+}
+
+// --compile-levels: text sources to .lvb next to them
+static int compile_levels(const std::string &dir)
+{
+    int compiled = 0;
+    for (int n = 1;; n++)
+    {
+        LevelData level;
+        if (!level.loadText(level_path(dir, n, ".txt")))
             break;
+        if (!level.saveBinary(level_path(dir, n, ".lvb")))
+        {
+            cout << "[WARN] Could not write " << level_path(dir, n, ".lvb") << endl;
+            return 1;
         }
+        cout << "[OK] " << level_path(dir, n, ".txt") << " -> " << level_path(dir, n, ".lvb") << endl;
+        compiled++;
     }
+    return compiled > 0 ? 0 : 1;
+}
 
-    void setupSprite(Texture &tex)
+// ============================================================================
+// CAMERA
+// ============================================================================
+// Screen-sized view over the world. follow() centers on a point and clamps to
+// the world so the view never shows past a level's edges; along an axis where
+// the world is no bigger than the screen the view stays anchored at 0, which
+// is where one-screen levels were always drawn.
+//
+// cull() is the frustum test every world sprite passes before it reaches the
+// sprite batch; it tallies visible and culled boxes per batch layer so the F3
+// overlay can show how much of the world is actually submitted.
+class Camera
+{
+public:
+    Camera() : worldW((float)SCREEN_WIDTH), worldH((float)SCREEN_HEIGHT)
     {
-        sprite.setTexture(tex);
-        sprite.setScale(PROJECTILE_SCALE, PROJECTILE_SCALE);
-        sprite.setTextureRect(IntRect(0, 0, ENEMY_FRAME_WIDTH, ENEMY_FRAME_HEIGHT));
+        view.reset(FloatRect(0, 0, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT));
+        visibleRect = bounds();
+        for (int l = 0; l < SpriteBatch::LAYER_COUNT; l++)
+            shown[l] = culled[l] = lastShown[l] = lastCulled[l] = 0;
     }
 
-    // Update movement, rolling, gravity, and platform interactions
-    void update(float dt, char **map)
+    void setWorld(float w, float h)
     {
-        if (!active)
-            return;
-
-        lifetime -= dt;
-        if (lifetime <= 0)
-        {
-            active = false;
-            return;
-        }
-
-        // Move vertically to target row before switching to rolling
-        if (movingToRow)
-        {
-            y += velocityY;
-            int targetY = platformTopY(desiredRow) - getSize();
-            bool reached = (dir == 1) ? (y <= targetY) : (y >= targetY);
-            if (reached)
-            {
-                y = targetY;
-                velocityY = 0;
-                isRolling = true;
-                movingToRow = false;
-                if (velocityX == 0)
-                    velocityX = (rollDir != 0 ? (float)rollDir : ((rand() % 2 == 0) ? 1.0f : -1.0f)) * ROLL_SPEED;
-            }
-        }
-        // Aerial motion until first platform contact flips to rolling
-        else if (!isRolling)
-        {
-            x += velocityX;
-            y += velocityY;
+        worldW = w;
+        worldH = h;
+    }
 
-            int gridY = (int)((y + getSize()) / CELL_SIZE);
-            int gridX = (int)((x + getSize() / 2) / CELL_SIZE);
+    void follow(float x, float y)
+    {
+        view.setCenter(clampAxis(x, (float)SCREEN_WIDTH, worldW),
+                       clampAxis(y, (float)SCREEN_HEIGHT, worldH));
+        visibleRect = bounds();
+    }
 
-            if (gridY >= 0 && gridY < LEVEL_HEIGHT && gridX >= 0 && gridX < LEVEL_WIDTH)
-            {
-                if (map[gridY][gridX] == '#' || map[gridY][gridX] == '/' || map[gridY][gridX] == '\\' || map[gridY][gridX] == 'S')
-                {
-                    isRolling = true;
-                    y = platformTopYAt(gridY, gridX) - getSize();
-                    velocityY = 0;
-                    if (velocityX == 0)
-                        velocityX = (rollDir != 0 ? (float)rollDir : ((rand() % 2 == 0) ? 1.0f : -1.0f)) * ROLL_SPEED;
-                }
-            }
-        }
-        // Rolling along platforms with light gravity to settle into slopes
+    // True when box overlaps the view; counted against layer either way
+    bool cull(int layer, const FloatRect &box)
+    {
+        bool visible = box.intersects(visibleRect);
+        if (visible)
+            shown[layer]++;
         else
-        {
-            x += velocityX;
-            velocityY += GRAVITY * 0.5f;
-            y += velocityY;
+            culled[layer]++;
+        return visible;
+    }
 
-            int gridY = (int)((y + getSize()) / CELL_SIZE);
-            int gridX = (int)((x + getSize() / 2) / CELL_SIZE);
+    // Closes the frame's tallies; lastVisible()/lastCulled() report them
+    void endFrame()
+    {
+        for (int l = 0; l < SpriteBatch::LAYER_COUNT; l++)
+        {
+            lastShown[l] = shown[l];
+            lastCulled[l] = culled[l];
+            shown[l] = culled[l] = 0;
+        }
+    }
 
-            if (gridY >= 0 && gridY < LEVEL_HEIGHT && gridX >= 0 && gridX < LEVEL_WIDTH)
-            {
-                if (map[gridY][gridX] == '#' || map[gridY][gridX] == '/' || map[gridY][gridX] == '\\' || map[gridY][gridX] == 'S')
-                {
-                    y = platformTopYAt(gridY, gridX) - getSize();
-                    velocityY = 0;
-                }
-            }
+    int lastVisible(int layer) const { return lastShown[layer]; }
+    int lastCulledCount(int layer) const { return lastCulled[layer]; }
 
-            // Bounce at screen edges to keep activity within bounds
-            if (x < 10)
-            {
-                x = 10;
-                velocityX = ROLL_SPEED;
-            }
-            if (x > SCREEN_WIDTH - getSize() - 10)
-            {
-                x = SCREEN_WIDTH - getSize() - 10;
-                velocityX = -ROLL_SPEED;
-            }
-            if (y > SCREEN_HEIGHT - getSize())
-            {
-                y = SCREEN_HEIGHT - getSize();
-                velocityY = 0;
-            }
-        }
+    const View &getView() const { return view; }
 
-        // Spin animations faster while rolling; place sprite at center of bounding box
-        rotation += (isRolling ? fabs(velocityX) * 1.2f : rotationSpeed);
-        sprite.setPosition(x, y);
-        // strict compliance: no rotation, use pre-baked spin frames
+    // World rectangle currently on screen
+    FloatRect bounds() const
+    {
+        return FloatRect(view.getCenter() - view.getSize() / 2.0f, view.getSize());
     }
 
-    bool collidesWith(Enemy &enemy)
+private:
+    static float clampAxis(float center, float screen, float world)
     {
-        if (!active || !enemy.active || enemy.captured)
-            return false;
-        return (x < enemy.x + enemy.getWidth() - 10 && x + getSize() > enemy.x + 10 &&
-                y < enemy.y + enemy.getHeight() - 10 && y + getSize() > enemy.y + 10);
+        float half = screen / 2.0f;
+        if (world <= screen)
+            return half;
+        return std::min(std::max(center, half), world - half);
     }
-
-    bool isAerial() { return !isRolling; }
-    int getSize() { return (int)(ENEMY_FRAME_WIDTH * 0.7f); }
+
+    View view;
+    FloatRect visibleRect;
+    float worldW, worldH;
+    int shown[SpriteBatch::LAYER_COUNT];
+    int culled[SpriteBatch::LAYER_COUNT];
+    int lastShown[SpriteBatch::LAYER_COUNT];
+    int lastCulled[SpriteBatch::LAYER_COUNT];
 };
 
 // ============================================================================
 // GAME CLASS - MAIN ENGINE
 // ============================================================================
+// Command-line settings. Headless runs open no window or audio, upload no
+// textures and step the simulation from a scripted input timeline.
+struct GameOptions
+{
+    bool headless = false;
+    std::string scriptPath;
+    int maxTicks = 60 * 60 * 10; // ten simulated minutes per session
+    int sessions = 1;
+    long long seed = -1; // -1 picks one from the clock
+    std::string recordPath;  // write this session's input to a replay file
+    std::string replayPath;  // drive the session from a replay file instead of input
+    float replaySpeed = 1.0f; // fast-forward factor for windowed replays
+    std::string tracePath;    // write a Chrome trace of profiler sections on exit
+    std::string levelDir = "Data/Levels"; // where level<N>.txt / .lvb are read from
+};
+
 class Game
 {
 public:
     RenderWindow window;
+    GameOptions options;
+    KeyboardInput keyboardInput;
+    ScriptedInput scriptedInput;
+    InputSource *inputSource = nullptr;
+    Profiler profiler;
+    bool showProfiler = false;
+    InputReplay recording;
+    InputReplay replay;
+    bool replaying = false;
+    uint64_t rngSeed = 0;
+    InputState input;
     GameState state;
 
-    // Textures
-    Texture playerGreenTex, playerYellowTex;
-    Texture playerGreenJumpTex, playerYellowJumpTex;
-    Texture greenRow1Tex, greenRow2Tex, yellowRow1Tex, yellowRow2Tex;
-    Texture ghostTex, skeletonTex, invisibleTex, invisibleDimTex, chelnovTex;
-    Texture bgTex, bg2Tex, platformTex;
-    Texture vacuumBeamTex, starsTex;
+    TextureCache textureCache;
+
+    // Textures (references into textureCache, bound in the constructor)
+    Texture &greenRow1Tex, &greenRow2Tex, &yellowRow1Tex, &yellowRow2Tex;
+    Texture &ghostTex, &skeletonTex, &invisibleTex, &invisibleDimTex, &chelnovTex;
+    Texture &bgTex, &bg2Tex, &platformTex;
+    Texture &vacuumBeamTex, &starsTex;
     int vacuumFrameW = 0;
     int vacuumTotalFrames = 0;
     int superWaveFrameW = 0;
     int superWaveTotalFrames = 0;
     vector<Texture> vacuumRainbowFrames;
-    Texture rollerSkatesTex, powTex;
-    Texture vacuumEffectTex, flashTex, mysteryBoxTex, potionTex, impactTex, bombRedTex, bombBlueTex;
-    Texture rainbowShotTex, debrisTex, superWaveTex;
-    Texture powerupSpeedTex, powerupRangeTex, powerupPowerTex, powerupLifeTex;
+    Texture &rollerSkatesTex, &powTex;
+    Texture &vacuumEffectTex, &flashTex, &mysteryBoxTex, &potionTex, &impactTex, &bombRedTex, &bombBlueTex;
+    Texture &rainbowShotTex, &debrisTex, &superWaveTex;
+    Texture &powerupSpeedTex, &powerupRangeTex, &powerupPowerTex, &powerupLifeTex;
 
     // UI helper textures for strict compliance (no tint/rotation)
-    Texture uiPxBlack120Tex, uiPxTitleBlue230Tex, uiPxYellowTex, uiPxOutlineGray80Tex;
-    Texture uiPxWhite28Tex, uiPxGreenOverlay180Tex, uiPxRedOverlay180Tex;
-    Texture uiPxYellowBox200Tex, uiPxGreenBox200Tex;
-    Texture beamRightTex, beamLeftTex, beamUpTex, beamDownTex;
-    Texture uiSweep18Tex;
-    Texture uiFontTex;
+    Texture &uiPxBlack120Tex, &uiPxTitleBlue230Tex, &uiPxYellowTex, &uiPxOutlineGray80Tex;
+    Texture &uiPxWhite28Tex, &uiPxGreenOverlay180Tex, &uiPxRedOverlay180Tex;
+    Texture &uiPxYellowBox200Tex, &uiPxGreenBox200Tex;
+    Texture &beamRightTex, &beamLeftTex, &beamUpTex, &beamDownTex;
+    Texture &uiSweep18Tex;
+    Texture &uiFontTex;
     bool useSpriteText = false;
     std::map<char, IntRect> uiGlyphs;
 
@@ -2716,16 +5575,23 @@ public:
     bool fontLoaded;
 
     Sprite bgSprite, platformSprite, vacuumBeamSprite;
-    Music menuMusic, bgMusic;
+    std::unique_ptr<Music> menuMusic; // null in headless runs
+    MusicStreamer bgMusic;
 
     Player player;
-    vector<Enemy> enemies;
-    vector<Projectile> projectiles;
-    vector<EnemyProjectile> enemyProjectiles;
+    EnemyStore enemies;
+    DensePool<Projectile> projectiles;
+    DensePool<EnemyProjectile> enemyProjectiles;
+
+    // Broad-phase collision buckets, rebuilt every tick in updateGameplay()
+    SpatialGrid enemyGrid;
+    SpatialGrid enemyShotGrid;
+    std::vector<int> gridHits;
 
     struct Effect
     {
         Sprite sprite;
+        RenderLerp lerp;
         float timer;
         int frames;
         float fps;
@@ -2734,24 +5600,30 @@ public:
         float vx, vy;
         float gravity;
         float lifetime;
-        std::vector<IntRect> customRects;
+        int clip = -1; // AnimClipRegistry id, or -1 to slice the strip by frameW
         const Texture *tex;
         int frameW;
         int texH;
     };
-    vector<Effect> effects;
+    DensePool<Effect> effects;
 
     vector<Powerup> powerups;
     ParticleSystem particles;
     ScoreManager scoreManager;
 
-    std::array<std::array<char, LEVEL_WIDTH>, LEVEL_HEIGHT> levelMap;
-    std::array<char *, LEVEL_HEIGHT> levelRows;
+    TileMap levelMap;
+    TileGrid tileGrid; // collision view of levelMap, rebuilt by buildLevel()
+    std::vector<TerrainChunk> terrain;
+    Camera camera;
+    uint32_t simTicks; // gameplay steps since launch; staggers far-enemy updates
     int currentLevel;
 
     void drawSpriteText(RenderWindow &w, const std::string &text, float x, float y, float scale = 1.0f, Color color = Color::White);
     float spriteTextWidth(const std::string &text, float scale = 1.0f);
     void drawRectTex(Texture &tex, float x, float y, float w, float h);
+    void drawSprite(RenderTarget &target, const Sprite &sprite);
+    TextureAtlas atlas;
+    SpriteBatch spriteBatch;
     int selectedCharacter;
     float shootCooldown;
     float burstCooldown;
@@ -2763,24 +5635,82 @@ public:
     float vacuumTrailTimer;
     float vacuumSuppressTimer;
     Clock gameClock;
+    float renderAlpha = 1.0f;
 
     // Character selection animation
     float characterSelectTimer;
     float characterBounce;
 
-    std::map<std::string, std::vector<IntRect>> effectMetaRects;
-    std::map<std::string, std::map<std::string, std::pair<int, int>>> effectLabels;
+    // Clip ids per numbered effect sheet, plus the sub-ranges effects play
+    static const int EFFECT_SHEETS = 12;
+    int effectClips[EFFECT_SHEETS];
+    int vacuumDisappearClip = -1;
+    int skeletonHitClip = -1;
+    int superWaveClip = -1;
+
+    const std::vector<IntRect> &effectRects(int sheet) const
+    {
+        return AnimClipRegistry::shared().frames(effectClips[sheet]);
+    }
     bool jumpGuiding;
     float jumpTargetX;
     bool seqActive;
     int seqStep;
     int seqOrder[4];
     int seqCounts[4];
+    std::vector<LevelData> levels; // index 0 is level 1
+    std::vector<std::string> levelTextures; // sheets acquired for the current level
     bool useWaveSpawning;
     int currentWave;
     float waveDelay;
 
-    Game() : window(VideoMode(SCREEN_WIDTH, SCREEN_HEIGHT), "TumblePop - Arcade Edition")
+    Game(const GameOptions &opts = GameOptions())
+           : options(opts),
+             greenRow1Tex(textureCache.acquire("Data/Asset/green_player_row_1.png")),
+             greenRow2Tex(textureCache.acquire("Data/Asset/green_player_row_2.png")),
+             yellowRow1Tex(textureCache.acquire("Data/Asset/yellow_player_row_1.png")),
+             yellowRow2Tex(textureCache.acquire("Data/Asset/yellow_player_row_2.png")),
+             ghostTex(textureCache.acquire("Data/Asset/ghost.png")),
+             skeletonTex(textureCache.acquire("Data/Asset/skeleton.png")),
+             invisibleTex(textureCache.acquire("Data/Asset/invisible.png")),
+             invisibleDimTex(textureCache.acquire("Data/Asset/invisible_dim.png")),
+             chelnovTex(textureCache.acquire("Data/Asset/chelnov.png")),
+             bgTex(textureCache.acquire("Data/Asset/bg.png")),
+             bg2Tex(textureCache.slot("Data/Asset/bg_level2.png")),
+             platformTex(textureCache.acquire("Data/Asset/block1.png")),
+             vacuumBeamTex(textureCache.acquire("Data/Asset/8.png")),
+             starsTex(textureCache.acquire("Data/Asset/8.png")),
+             rollerSkatesTex(textureCache.acquire("Data/Asset/0.png")),
+             powTex(textureCache.acquire("Data/Asset/1.png")),
+             vacuumEffectTex(textureCache.acquire("Data/Asset/2.png")),
+             flashTex(textureCache.acquire("Data/Asset/3.png")),
+             mysteryBoxTex(textureCache.acquire("Data/Asset/4.png")),
+             potionTex(textureCache.acquire("Data/Asset/5.png")),
+             impactTex(textureCache.acquire("Data/Asset/6.png")),
+             bombRedTex(textureCache.acquire("Data/Asset/7.png")),
+             bombBlueTex(textureCache.acquire("Data/Asset/10.png")),
+             rainbowShotTex(textureCache.acquire("Data/Asset/8.png")),
+             debrisTex(textureCache.acquire("Data/Asset/9.png")),
+             superWaveTex(textureCache.acquire("Data/Asset/11.png")),
+             powerupSpeedTex(textureCache.acquire("Data/Asset/0.png")),
+             powerupRangeTex(textureCache.acquire("Data/Asset/2.png")),
+             powerupPowerTex(textureCache.acquire("Data/Asset/5.png")),
+             powerupLifeTex(textureCache.acquire("Data/Asset/3.png")),
+             uiPxBlack120Tex(textureCache.acquire("Data/Asset/color/ui_px_black_120.png")),
+             uiPxTitleBlue230Tex(textureCache.acquire("Data/Asset/color/ui_px_title_blue_230.png")),
+             uiPxYellowTex(textureCache.acquire("Data/Asset/color/ui_px_yellow.png")),
+             uiPxOutlineGray80Tex(textureCache.acquire("Data/Asset/color/ui_px_outline_gray_80.png")),
+             uiPxWhite28Tex(textureCache.acquire("Data/Asset/color/ui_px_white_28.png")),
+             uiPxGreenOverlay180Tex(textureCache.acquire("Data/Asset/color/ui_px_green_overlay_180.png")),
+             uiPxRedOverlay180Tex(textureCache.acquire("Data/Asset/color/ui_px_red_overlay_180.png")),
+             uiPxYellowBox200Tex(textureCache.acquire("Data/Asset/color/ui_px_yellow_box_200.png")),
+             uiPxGreenBox200Tex(textureCache.acquire("Data/Asset/color/ui_px_green_box_200.png")),
+             beamRightTex(textureCache.acquire("Data/Asset/beam/beam_right.png")),
+             beamLeftTex(textureCache.acquire("Data/Asset/beam/beam_left.png")),
+             beamUpTex(textureCache.acquire("Data/Asset/beam/beam_up.png")),
+             beamDownTex(textureCache.acquire("Data/Asset/beam/beam_down.png")),
+             uiSweep18Tex(textureCache.acquire("Data/Asset/ui_sweep_18.png")),
+             uiFontTex(textureCache.acquire("Data/Asset/ui_font.png"))
     {
         state = CHARACTER_SELECT;
         currentLevel = 1;
@@ -2800,14 +5730,46 @@ public:
         jumpGuiding = false;
         jumpTargetX = 0;
 
-        for (int i = 0; i < LEVEL_HEIGHT; i++)
+        simTicks = 0;
+
+        if (options.headless)
+        {
+            if (!options.scriptPath.empty() && !scriptedInput.loadFromFile(options.scriptPath))
+                cout << "[WARN] Could not read input script " << options.scriptPath << endl;
+            inputSource = &scriptedInput;
+            textureCache.setOffline(true);
+        }
+        else
         {
-            for (int j = 0; j < LEVEL_WIDTH; j++)
-                levelMap[i][j] = ' ';
-            levelRows[i] = levelMap[i].data();
+            window.create(VideoMode(SCREEN_WIDTH, SCREEN_HEIGHT), "TumblePop - Arcade Edition");
+            inputSource = &keyboardInput;
+            // Headless runs never construct an sf::Music, so they need no audio device
+            menuMusic.reset(new Music());
+            bgMusic.enable();
         }
 
-        srand((unsigned)time(0));
+        projectiles.reserve(PROJECTILE_POOL, "projectile");
+        enemyProjectiles.reserve(ENEMY_PROJECTILE_POOL, "enemy projectile");
+        effects.reserve(EFFECT_POOL, "effect");
+
+        rngSeed = options.seed >= 0 ? (uint64_t)options.seed : (uint64_t)time(0);
+        if (!options.replayPath.empty())
+        {
+            replaying = replay.load(options.replayPath);
+            if (replaying)
+            {
+                rngSeed = replay.seed;
+                selectedCharacter = replay.character;
+                cout << "[OK] Replay " << options.replayPath << ": " << replay.tickCount()
+                     << " ticks, seed " << replay.seed << endl;
+            }
+            else
+                cout << "[WARN] Could not read replay " << options.replayPath << endl;
+        }
+        seed_rng_streams(rngSeed);
+        recording.reset(rngSeed);
+        profiler.setTracing(!options.tracePath.empty());
+        cout << "[OK] RNG seed " << rngSeed << " (replay with --seed " << rngSeed << ")" << endl;
         loadAssets();
         seqActive = false;
         seqStep = 0;
@@ -2826,12 +5788,7 @@ public:
 
     ~Game() {}
 
-    char **mapPtr()
-    {
-        for (int i = 0; i < LEVEL_HEIGHT; i++)
-            levelRows[i] = levelMap[i].data();
-        return levelRows.data();
-    }
+    const LevelData &levelData(int level) const { return levels[level - 1]; }
 
     void loadAssets()
     {
@@ -2840,6 +5797,25 @@ public:
         cout << "========================================\n"
              << endl;
 
+        // The progress bar needs its own pixels up front; everything else is
+        // decoded on worker threads while the bar fills, then uploaded below
+        textureCache.load("Data/Asset/color/ui_px_black_120.png");
+        textureCache.load("Data/Asset/color/ui_px_yellow.png");
+        textureCache.load("Data/Asset/color/ui_px_outline_gray_80.png");
+        textureCache.startDecode(textureCache.pendingPaths());
+        while (!options.headless && !textureCache.decodeFinished())
+        {
+            Event event;
+            while (window.pollEvent(event))
+            {
+            }
+            renderLoadingScreen(textureCache.decodeProgress());
+            sleep(milliseconds(5));
+        }
+        textureCache.finishDecode();
+        if (!options.headless)
+            renderLoadingScreen(1.0f);
+
         if (gameFont.loadFromFile("Data/Asset/arcade.ttf"))
         {
             fontLoaded = true;
@@ -2852,85 +5828,85 @@ public:
         }
 
         // Player sprite sheets - prioritize imp folder (png lowercase)
-        if (greenRow1Tex.loadFromFile("Data/Asset/green_player_row_1.png"))
+        if (textureCache.load("Data/Asset/green_player_row_1.png"))
         {
             cout << "[OK] green_player_row_1.png (imp)" << endl;
         }
-        else if (greenRow1Tex.loadFromFile("Data/Asset/green_player_row_1.PNG") ||
-                 greenRow1Tex.loadFromFile("Data/Players/player_green_walk.png"))
+        else if (textureCache.load("Data/Asset/green_player_row_1.png", "Data/Asset/green_player_row_1.PNG") ||
+                 textureCache.load("Data/Asset/green_player_row_1.png", "Data/Players/player_green_walk.png"))
         {
             cout << "[OK] player_green_walk.png" << endl;
         }
 
-        if (greenRow2Tex.loadFromFile("Data/Asset/green_player_row_2.png"))
+        if (textureCache.load("Data/Asset/green_player_row_2.png"))
         {
             cout << "[OK] green_player_row_2.png (imp)" << endl;
         }
 
-        if (yellowRow1Tex.loadFromFile("Data/Asset/yellow_player_row_1.png"))
+        if (textureCache.load("Data/Asset/yellow_player_row_1.png"))
         {
             cout << "[OK] yellow_player_row_1.png (imp)" << endl;
         }
-        else if (yellowRow1Tex.loadFromFile("Data/Asset/yellow_player_row_1.PNG") ||
-                 yellowRow1Tex.loadFromFile("Data/Players/player_yellow_walk.png"))
+        else if (textureCache.load("Data/Asset/yellow_player_row_1.png", "Data/Asset/yellow_player_row_1.PNG") ||
+                 textureCache.load("Data/Asset/yellow_player_row_1.png", "Data/Players/player_yellow_walk.png"))
         {
             cout << "[OK] player_yellow_walk.png" << endl;
         }
 
-        if (yellowRow2Tex.loadFromFile("Data/Asset/yellow_player_row_2.png"))
+        if (textureCache.load("Data/Asset/yellow_player_row_2.png"))
         {
             cout << "[OK] yellow_player_row_2.png (imp)" << endl;
         }
 
         // Enemies - prioritize imp folder
-        if (ghostTex.loadFromFile("Data/Asset/ghost.png"))
+        if (textureCache.load("Data/Asset/ghost.png"))
         {
             cout << "[OK] ghost.png (imp)" << endl;
         }
-        else if (ghostTex.loadFromFile("Data/Enemies/ghost.png"))
+        else if (textureCache.load("Data/Asset/ghost.png", "Data/Enemies/ghost.png"))
         {
             cout << "[OK] ghost.png" << endl;
         }
 
-        if (skeletonTex.loadFromFile("Data/Asset/skeleton.png"))
+        if (textureCache.load("Data/Asset/skeleton.png"))
         {
             cout << "[OK] skeleton.png (imp)" << endl;
         }
-        else if (skeletonTex.loadFromFile("Data/Enemies/skeleton.png"))
+        else if (textureCache.load("Data/Asset/skeleton.png", "Data/Enemies/skeleton.png"))
         {
             cout << "[OK] skeleton.png" << endl;
         }
 
-        if (invisibleTex.loadFromFile("Data/Asset/invisible.png"))
+        if (textureCache.load("Data/Asset/invisible.png"))
         {
             cout << "[OK] invisible.png (imp)" << endl;
         }
-        else if (invisibleTex.loadFromFile("Data/Enemies/invisible_man.png"))
+        else if (textureCache.load("Data/Asset/invisible.png", "Data/Enemies/invisible_man.png"))
         {
             cout << "[OK] invisible_man.png" << endl;
         }
-        if (invisibleDimTex.loadFromFile("Data/Asset/invisible_dim.png"))
+        if (textureCache.load("Data/Asset/invisible_dim.png"))
         {
             cout << "[OK] invisible_dim.png (Asset dim)" << endl;
         }
 
-        if (chelnovTex.loadFromFile("Data/Asset/chelnov.png"))
+        if (textureCache.load("Data/Asset/chelnov.png"))
         {
             cout << "[OK] chelnov.png (imp)" << endl;
         }
-        else if (chelnovTex.loadFromFile("Data/Enemies/chelnov.png"))
+        else if (textureCache.load("Data/Asset/chelnov.png", "Data/Enemies/chelnov.png"))
         {
             cout << "[OK] chelnov.png" << endl;
         }
 
-        if (vacuumBeamTex.loadFromFile("Data/Asset/8.png"))
+        if (textureCache.load("Data/Asset/8.png"))
         {
             cout << "[OK] Vacuum Beam (8.png) loaded" << endl;
             // Analyze frames
-            int h = vacuumBeamTex.getSize().y;
+            int h = sheetSize(vacuumBeamTex).y;
             if (h > 0)
             {
-                vacuumTotalFrames = vacuumBeamTex.getSize().x / h;
+                vacuumTotalFrames = sheetSize(vacuumBeamTex).x / h;
                 vacuumFrameW = h;
                 if (vacuumTotalFrames < 1)
                     vacuumTotalFrames = 1;
@@ -2939,29 +5915,30 @@ public:
             }
             vacuumBeamSprite.setTexture(vacuumBeamTex);
         }
-        else if (vacuumBeamTex.loadFromFile("Data/Asset/vacuum_beam.png"))
+        else if (textureCache.load("Data/Asset/vacuum_beam.png"))
         {
+            // Own slot: 8.png is shared with the stars and the rainbow shot
             cout << "[OK] vacuum_beam.png" << endl;
-            vacuumBeamSprite.setTexture(vacuumBeamTex);
+            vacuumBeamSprite.setTexture(textureCache.acquire("Data/Asset/vacuum_beam.png"));
         }
 
         // Load effect textures from imp folder
-        rollerSkatesTex.loadFromFile("Data/Asset/0.png");
-        powTex.loadFromFile("Data/Asset/1.png");
-        vacuumEffectTex.loadFromFile("Data/Asset/2.png");
-        flashTex.loadFromFile("Data/Asset/3.png");
-        mysteryBoxTex.loadFromFile("Data/Asset/4.png");
-        potionTex.loadFromFile("Data/Asset/5.png");
-        impactTex.loadFromFile("Data/Asset/6.png");
-        bombRedTex.loadFromFile("Data/Asset/7.png");
-        bombBlueTex.loadFromFile("Data/Asset/10.png");
-        rainbowShotTex.loadFromFile("Data/Asset/8.png");
-        debrisTex.loadFromFile("Data/Asset/9.png");
-        superWaveTex.loadFromFile("Data/Asset/11.png");
-        if (superWaveTex.getSize().y > 0)
-        {
-            int h = superWaveTex.getSize().y;
-            superWaveTotalFrames = superWaveTex.getSize().x / h;
+        textureCache.load("Data/Asset/0.png");
+        textureCache.load("Data/Asset/1.png");
+        textureCache.load("Data/Asset/2.png");
+        textureCache.load("Data/Asset/3.png");
+        textureCache.load("Data/Asset/4.png");
+        textureCache.load("Data/Asset/5.png");
+        textureCache.load("Data/Asset/6.png");
+        textureCache.load("Data/Asset/7.png");
+        textureCache.load("Data/Asset/10.png");
+        textureCache.load("Data/Asset/8.png");
+        textureCache.load("Data/Asset/9.png");
+        textureCache.load("Data/Asset/11.png");
+        if (sheetSize(superWaveTex).y > 0)
+        {
+            int h = sheetSize(superWaveTex).y;
+            superWaveTotalFrames = sheetSize(superWaveTex).x / h;
             superWaveFrameW = h;
             if (superWaveTotalFrames < 1)
                 superWaveTotalFrames = 1;
@@ -2971,10 +5948,10 @@ public:
         auto buildRects = [&](Texture &tex)
         {
             std::vector<IntRect> out;
-            if (tex.getSize().x == 0 || tex.getSize().y == 0)
+            if (sheetSize(tex).x == 0 || sheetSize(tex).y == 0)
                 return out;
-            int w = (int)tex.getSize().x;
-            int h = (int)tex.getSize().y;
+            int w = (int)sheetSize(tex).x;
+            int h = (int)sheetSize(tex).y;
             int fw = ENEMY_FRAME_WIDTH;
             int frames = std::max(1, w / fw);
             out.reserve(frames);
@@ -2983,40 +5960,56 @@ public:
             return out;
         };
 
-        effectMetaRects["0"] = buildRects(rollerSkatesTex);
-        effectMetaRects["1"] = buildRects(powTex);
-        effectMetaRects["2"] = buildRects(vacuumEffectTex);
-        effectMetaRects["3"] = buildRects(flashTex);
-        effectMetaRects["4"] = buildRects(mysteryBoxTex);
-        effectMetaRects["5"] = buildRects(potionTex);
-        effectMetaRects["6"] = buildRects(impactTex);
-        effectMetaRects["7"] = buildRects(bombRedTex);
-        effectMetaRects["8"] = buildRects(rainbowShotTex);
-        effectMetaRects["9"] = buildRects(debrisTex);
-        effectMetaRects["10"] = buildRects(bombBlueTex);
-        effectMetaRects["11"] = buildRects(superWaveTex);
-
-        std::vector<IntRect> r2 = effectMetaRects["2"];
+        AnimClipRegistry &clips = AnimClipRegistry::shared();
+        clips.clear();
+        Texture *effectSheets[EFFECT_SHEETS] = {
+            &rollerSkatesTex, &powTex, &vacuumEffectTex, &flashTex,
+            &mysteryBoxTex, &potionTex, &impactTex, &bombRedTex,
+            &rainbowShotTex, &debrisTex, &bombBlueTex, &superWaveTex};
+        for (int i = 0; i < EFFECT_SHEETS; ++i)
+            effectClips[i] = clips.add(buildRects(*effectSheets[i]));
+
+        // Vacuum pickup plays the last four frames of 2.png ("disappear")
+        const std::vector<IntRect> &r2 = effectRects(2);
         if (!r2.empty())
         {
-            int n = (int)r2.size();
-            int a = std::max(0, n - 4);
-            int b = n - 1;
-            effectLabels["2"]["disappear"] = std::make_pair(a, b);
+            int a = std::max(0, (int)r2.size() - 4);
+            vacuumDisappearClip = clips.add(std::vector<IntRect>(r2.begin() + a, r2.end()));
+        }
+
+        // Skeleton hit flash: frames 19-24 of the skeleton strip
+        if (sheetSize(skeletonTex).x > 0)
+        {
+            std::vector<IntRect> hit;
+            int fh = sheetSize(skeletonTex).y;
+            for (int i = 19; i <= 24; ++i)
+                hit.push_back(IntRect(i * ENEMY_FRAME_WIDTH, 0, ENEMY_FRAME_WIDTH, fh));
+            skeletonHitClip = clips.add(hit);
+        }
+
+        // Super wave uses square frames sized by the sheet height
+        if (sheetSize(superWaveTex).y > 0)
+        {
+            std::vector<IntRect> wave;
+            int fh = sheetSize(superWaveTex).y;
+            int frames = std::max(1, (int)sheetSize(superWaveTex).x / fh);
+            for (int i = 0; i < frames; ++i)
+                wave.push_back(IntRect(i * fh, 0, fh, fh));
+            superWaveClip = clips.add(wave);
         }
 
-        if (starsTex.loadFromFile("Data/Asset/8.png"))
+        if (textureCache.load("Data/Asset/8.png"))
         {
             cout << "[OK] stars.png" << endl;
         }
 
-        powerupSpeedTex.loadFromFile("Data/Asset/0.png");
-        powerupRangeTex.loadFromFile("Data/Asset/2.png");
-        powerupPowerTex.loadFromFile("Data/Asset/5.png");
-        powerupLifeTex.loadFromFile("Data/Asset/3.png");
+        textureCache.load("Data/Asset/0.png");
+        textureCache.load("Data/Asset/2.png");
+        textureCache.load("Data/Asset/5.png");
+        textureCache.load("Data/Asset/3.png");
 
         // Optional UI bitmap font atlas (sprite-based text)
-        if (uiFontTex.loadFromFile("Data/Asset/ui_font.png"))
+        if (textureCache.load("Data/Asset/ui_font.png"))
         {
             useSpriteText = true;
             // Example glyph mapping: assumes monospace cells 16x24 arranged in rows
@@ -3040,89 +6033,306 @@ public:
         }
 
         // UI color pixels
-        uiPxBlack120Tex.loadFromFile("Data/Asset/color/ui_px_black_120.png");
-        uiPxTitleBlue230Tex.loadFromFile("Data/Asset/color/ui_px_title_blue_230.png");
-        uiPxYellowTex.loadFromFile("Data/Asset/color/ui_px_yellow.png");
-        uiPxOutlineGray80Tex.loadFromFile("Data/Asset/color/ui_px_outline_gray_80.png");
-        uiPxWhite28Tex.loadFromFile("Data/Asset/color/ui_px_white_28.png");
-        uiPxGreenOverlay180Tex.loadFromFile("Data/Asset/color/ui_px_green_overlay_180.png");
-        uiPxRedOverlay180Tex.loadFromFile("Data/Asset/color/ui_px_red_overlay_180.png");
-        uiPxYellowBox200Tex.loadFromFile("Data/Asset/color/ui_px_yellow_box_200.png");
-        uiPxGreenBox200Tex.loadFromFile("Data/Asset/color/ui_px_green_box_200.png");
+        textureCache.load("Data/Asset/color/ui_px_black_120.png");
+        textureCache.load("Data/Asset/color/ui_px_title_blue_230.png");
+        textureCache.load("Data/Asset/color/ui_px_yellow.png");
+        textureCache.load("Data/Asset/color/ui_px_outline_gray_80.png");
+        textureCache.load("Data/Asset/color/ui_px_white_28.png");
+        textureCache.load("Data/Asset/color/ui_px_green_overlay_180.png");
+        textureCache.load("Data/Asset/color/ui_px_red_overlay_180.png");
+        textureCache.load("Data/Asset/color/ui_px_yellow_box_200.png");
+        textureCache.load("Data/Asset/color/ui_px_green_box_200.png");
 
         // Beam directional sheets
-        beamRightTex.loadFromFile("Data/Asset/beam/beam_right.png");
-        beamLeftTex.loadFromFile("Data/Asset/beam/beam_left.png");
-        beamUpTex.loadFromFile("Data/Asset/beam/beam_up.png");
-        beamDownTex.loadFromFile("Data/Asset/beam/beam_down.png");
+        textureCache.load("Data/Asset/beam/beam_right.png");
+        textureCache.load("Data/Asset/beam/beam_left.png");
+        textureCache.load("Data/Asset/beam/beam_up.png");
+        textureCache.load("Data/Asset/beam/beam_down.png");
         // Pre-rotated sweep
-        uiSweep18Tex.loadFromFile("Data/Asset/ui_sweep_18.png");
+        textureCache.load("Data/Asset/ui_sweep_18.png");
 
-        if (bgTex.loadFromFile("Data/Asset/bg.png"))
+        if (textureCache.load("Data/Asset/bg.png"))
         {
             cout << "[OK] bg.png (imp level1)" << endl;
             bgSprite.setTexture(bgTex);
-            bgSprite.setScale((float)SCREEN_WIDTH / bgTex.getSize().x,
-                              (float)SCREEN_HEIGHT / bgTex.getSize().y);
+            bgSprite.setScale((float)SCREEN_WIDTH / sheetSize(bgTex).x,
+                              (float)SCREEN_HEIGHT / sheetSize(bgTex).y);
         }
 
-        bg2Tex.loadFromFile("Data/Asset/bg_level2.png");
 
-        if (platformTex.loadFromFile("Data/Asset/block1.png"))
+        if (textureCache.load("Data/Asset/block1.png"))
         {
             cout << "[OK] block1.png (imp)" << endl;
             platformSprite.setTexture(platformTex);
-            platformSprite.setScale((float)CELL_SIZE / platformTex.getSize().x,
-                                    (float)CELL_SIZE / platformTex.getSize().y);
+            platformSprite.setScale((float)CELL_SIZE / sheetSize(platformTex).x,
+                                    (float)CELL_SIZE / sheetSize(platformTex).y);
+            // Ramp strips run their U coordinate past the texture width
+            platformTex.setRepeated(true);
         }
 
         // Disable smoothing for pixel art
 
         bool musicLoaded = false;
-        if (menuMusic.openFromFile("Data/Asset/mus.ogg"))
+        if (!menuMusic)
+        {
+            // No audio device in headless runs
+        }
+        else if (menuMusic->openFromFile("Data/Asset/mus.ogg"))
         {
             musicLoaded = true;
         }
-        else if (menuMusic.openFromFile("Data/Asset/music_level2.ogg"))
+        else if (menuMusic->openFromFile("Data/Asset/music_level2.ogg"))
         {
             musicLoaded = true;
         }
 
         if (musicLoaded)
         {
-            menuMusic.setVolume(50);
-            menuMusic.setLoop(true);
-            menuMusic.play();
+            menuMusic->setVolume(50);
+            menuMusic->setLoop(true);
+            menuMusic->play();
             cout << "[OK] Menu music playing" << endl;
         }
 
-        bgMusic.openFromFile("Data/Asset/mus.ogg");
         bgMusic.setVolume(40);
-        bgMusic.setLoop(true);
+        bgMusic.prefetch("Data/Asset/mus.ogg");
+
+        cout << "[OK] Texture cache: " << textureCache.residentCount() << " of " << textureCache.slotCount()
+             << " files resident (" << textureCache.getDecodeCount() << " decodes)" << endl;
+
+        if (!options.headless)
+            buildAtlas();
 
         // Initialize player with proper sprite sheets
         player.setupSprite(yellowRow1Tex);
         player.bindSheets(&yellowRow1Tex, &yellowRow2Tex);
         player.loadMetaLabels("yellow");
 
+        levels = load_levels(options.levelDir);
+        Logger::instance().flush(); // its lines go through the log queue
+        if (levels.empty())
+            throw std::runtime_error("No levels found (expected " + level_path(options.levelDir, 1, ".txt") + ")");
+
         cout << "\n[DONE] Asset loading complete!\n"
              << endl;
     }
 
+    // Progress bar shown while loadAssets() decodes textures
+    void renderLoadingScreen(float progress)
+    {
+        float barW = 600.0f;
+        float barH = 28.0f;
+        float x = (SCREEN_WIDTH - barW) / 2;
+        float y = SCREEN_HEIGHT * 0.6f;
+        window.clear(Color::Black);
+        drawRectTex(uiPxOutlineGray80Tex, x - 3, y - 3, barW + 6, barH + 6);
+        drawRectTex(uiPxBlack120Tex, x, y, barW, barH);
+        drawRectTex(uiPxYellowTex, x, y, barW * std::min(1.0f, std::max(0.0f, progress)), barH);
+        window.display();
+    }
+
+    // Pack every sprite sheet, effect strip, UI pixel and the UI font into shared
+    // atlas pages. Backgrounds stay separate (full-screen) and so does the block
+    // texture, which is sampled with repeat by the ramp layer.
+    void buildAtlas()
+    {
+        atlas.clear();
+        Texture *sheets[] = {
+            &greenRow1Tex, &greenRow2Tex, &yellowRow1Tex, &yellowRow2Tex,
+            &ghostTex, &skeletonTex, &invisibleTex, &invisibleDimTex, &chelnovTex,
+            &vacuumBeamTex, &starsTex, &superWaveTex, &rainbowShotTex, &debrisTex,
+            &rollerSkatesTex, &powTex, &vacuumEffectTex, &flashTex, &mysteryBoxTex,
+            &potionTex, &impactTex, &bombRedTex, &bombBlueTex,
+            &powerupSpeedTex, &powerupRangeTex, &powerupPowerTex, &powerupLifeTex,
+            &uiPxBlack120Tex, &uiPxTitleBlue230Tex, &uiPxYellowTex, &uiPxOutlineGray80Tex,
+            &uiPxWhite28Tex, &uiPxGreenOverlay180Tex, &uiPxRedOverlay180Tex,
+            &uiPxYellowBox200Tex, &uiPxGreenBox200Tex,
+            &beamRightTex, &beamLeftTex, &beamUpTex, &beamDownTex,
+            &uiSweep18Tex, &uiFontTex};
+        for (size_t i = 0; i < sizeof(sheets) / sizeof(sheets[0]); i++)
+            atlas.add(*sheets[i]);
+        atlas.build();
+        cout << "[OK] Texture atlas: " << atlas.regionCount() << " sheets on "
+             << atlas.pageCount() << " page(s)" << endl;
+    }
+
     void run()
     {
+        if (options.headless)
+        {
+            runHeadless();
+            return;
+        }
+
         printControls();
 
+        float accumulator = 0;
         while (window.isOpen())
         {
-            float dt = gameClock.restart().asSeconds();
-            if (dt > 0.1f)
-                dt = 0.1f;
+            ProfileScope frameScope(profiler, PROF_FRAME);
+            float frameTime = gameClock.restart().asSeconds();
+            if (frameTime > MAX_FRAME_TIME)
+                frameTime = MAX_FRAME_TIME;
+            accumulator += replaying ? frameTime * options.replaySpeed : frameTime;
 
             handleInput();
-            update(dt);
+            // Simulation always advances in FIXED_DT steps so per-step physics
+            // (gravity, effect drift) is the same at any display rate
+            while (accumulator >= FIXED_DT)
+            {
+                stepInput();
+                beginStepLerp();
+                update(FIXED_DT);
+                endStepLerp();
+                accumulator -= FIXED_DT;
+            }
+            renderAlpha = accumulator / FIXED_DT;
             render();
+            frameScope.stop();
+            profiler.endFrame();
+        }
+        Logger::instance().flush();
+        saveRecording();
+        saveTrace();
+    }
+
+    // Samples this tick's input from the replay or the live source, and
+    // appends it to the recording
+    void stepInput()
+    {
+        if (replaying)
+            input.apply(replay.next());
+        else
+        {
+            inputSource->advance();
+            input.capture(*inputSource);
+        }
+        if (!options.recordPath.empty())
+            recording.record(input.bits());
+    }
+
+    void saveTrace()
+    {
+        if (options.tracePath.empty())
+            return;
+        if (profiler.exportChromeTrace(options.tracePath))
+            cout << "[OK] Wrote " << profiler.traceEventCount() << " trace events to " << options.tracePath << endl;
+        else
+            cout << "[WARN] Could not write trace " << options.tracePath << endl;
+    }
+
+    void saveRecording()
+    {
+        if (options.recordPath.empty())
+            return;
+        recording.character = selectedCharacter;
+        if (recording.save(options.recordPath))
+            cout << "[OK] Recorded " << recording.tickCount() << " ticks to " << options.recordPath << endl;
+        else
+            cout << "[WARN] Could not write replay " << options.recordPath << endl;
+    }
+
+    // Buckets every live enemy by its box; returns the widest enemy so callers
+    // can pad proximity queries
+    float rebuildEnemyGrid()
+    {
+        const EnemyMotion &hot = enemies.hot;
+        float maxW = 0;
+        enemyGrid.clear();
+        for (size_t i = 0; i < hot.size(); i++)
+        {
+            if (!hot.live(i))
+                continue;
+            enemyGrid.insert((int)i, hot.box(i));
+            maxW = std::max(maxW, hot.width[i]);
         }
+        return maxW;
+    }
+
+    // Steps the simulation as fast as possible from the input script, once per
+    // session, and prints one summary line per session
+    void runHeadless()
+    {
+        Clock wall;
+        for (int session = 0; session < options.sessions; session++)
+        {
+            scoreManager.reset();
+            state = CHARACTER_SELECT;
+            deathTimer = 0;
+            iframeTimer = 0;
+            scriptedInput.rewind();
+            input.clear();
+            if (replaying)
+            {
+                // Every session of a replay reproduces the same run
+                replay.rewind();
+                seed_rng_streams(rngSeed);
+            }
+
+            int tick = 0;
+            while (tick < options.maxTicks && state != GAME_OVER && state != VICTORY &&
+                   !(replaying && replay.finished()))
+            {
+                stepInput();
+                update(FIXED_DT);
+                profiler.endFrame();
+                tick++;
+            }
+
+            const char *outcome = (state == VICTORY) ? "victory" : (state == GAME_OVER) ? "game_over"
+                                  : replaying && replay.finished()                      ? "replay_end"
+                                                                                       : "timeout";
+            Logger::instance().flush();
+            cout << "[HEADLESS] session " << session + 1 << " " << outcome
+                 << " ticks=" << tick << " level=" << currentLevel
+                 << " score=" << scoreManager.score << " health=" << player.health << endl;
+        }
+        cout << "[HEADLESS] " << options.sessions << " session(s) in "
+             << wall.getElapsedTime().asSeconds() << "s" << endl;
+        saveRecording();
+        saveTrace();
+    }
+
+    // Record sprite positions around each fixed step for render interpolation
+    void beginStepLerp()
+    {
+        player.lerp.beginStep(player.sprite);
+        for (size_t i = 0; i < enemies.size(); i++)
+            enemies[i].lerp.beginStep(enemies[i].sprite);
+        for (size_t i = 0; i < projectiles.size(); i++)
+            projectiles[i].lerp.beginStep(projectiles[i].sprite);
+        for (size_t i = 0; i < enemyProjectiles.size(); i++)
+            enemyProjectiles[i].lerp.beginStep(enemyProjectiles[i].sprite);
+        for (size_t i = 0; i < effects.size(); i++)
+            effects[i].lerp.beginStep(effects[i].sprite);
+    }
+
+    void endStepLerp()
+    {
+        player.lerp.endStep(player.sprite);
+        for (size_t i = 0; i < enemies.size(); i++)
+            enemies[i].lerp.endStep(enemies[i].sprite);
+        for (size_t i = 0; i < projectiles.size(); i++)
+            projectiles[i].lerp.endStep(projectiles[i].sprite);
+        for (size_t i = 0; i < enemyProjectiles.size(); i++)
+            enemyProjectiles[i].lerp.endStep(enemyProjectiles[i].sprite);
+        for (size_t i = 0; i < effects.size(); i++)
+            effects[i].lerp.endStep(effects[i].sprite);
+    }
+
+    // Draws a world sprite at its interpolated position unless it falls
+    // outside the camera; counted against the batch's current layer
+    void drawLerped(const Sprite &sprite, const RenderLerp &lerp)
+    {
+        Vector2f offset = lerp.offset(renderAlpha);
+        FloatRect box = sprite.getGlobalBounds();
+        box.left += offset.x;
+        box.top += offset.y;
+        if (!camera.cull(spriteBatch.getLayer(), box))
+            return;
+        Sprite s(sprite);
+        s.move(offset);
+        drawSprite(window, s);
     }
 
     void printControls()
@@ -3159,16 +6369,21 @@ private:
         {
             if (event.type == Event::Closed)
                 window.close();
+            // F3 is a debug key, kept out of InputState so replays don't see it
+            if (event.type == Event::KeyPressed && event.key.code == Keyboard::F3)
+                showProfiler = !showProfiler;
         }
 
-        if (Keyboard::isKeyPressed(Keyboard::Escape))
+        if (input.down(InputState::QUIT))
             window.close();
     }
 
     void update(float dt)
     {
+        ProfileScope scope(profiler, PROF_UPDATE);
         titleAnimTimer += dt;
         vacuumAnimTimer += dt;
+        bgMusic.update(dt);
         if (deathTimer > 0)
         {
             deathTimer -= dt;
@@ -3176,6 +6391,7 @@ private:
             {
                 state = GAME_OVER;
                 bgMusic.stop();
+                bgMusic.prefetch("Data/Asset/mus.ogg");
             }
         }
         characterSelectTimer += dt;
@@ -3204,48 +6420,45 @@ private:
             updateGameOver();
             break;
         }
+
+        // Drop everything that despawned this tick so loops only walk live entries
+        projectiles.compact();
+        enemyProjectiles.compact();
+        effects.compact();
     }
 
     void updateCharacterSelect()
     {
-        static bool key1Pressed = false, key2Pressed = false, enterPressed = false;
-        bool key1Now = Keyboard::isKeyPressed(Keyboard::Num1);
-        bool key2Now = Keyboard::isKeyPressed(Keyboard::Num2);
-        bool enterNow = Keyboard::isKeyPressed(Keyboard::Enter);
-
-        if (key1Now && !key1Pressed)
+        if (input.pressed(InputState::SELECT_YELLOW))
         {
             selectedCharacter = 0;
             player.setCharacter(true);
             player.setupSprite(yellowRow1Tex);
             player.bindSheets(&yellowRow1Tex, &yellowRow2Tex);
             player.loadMetaLabels("yellow");
-            cout << "[SELECT] YELLOW Character!" << endl;
+            LOG_INFO("[SELECT] YELLOW Character!");
 
             // Particle effect
             particles.emit(Vector2f(SCREEN_WIDTH / 2 - 200, 400), Color::Yellow, 20);
         }
-        if (key2Now && !key2Pressed)
+        if (input.pressed(InputState::SELECT_GREEN))
         {
             selectedCharacter = 1;
             player.setCharacter(false);
             player.setupSprite(greenRow1Tex);
             player.bindSheets(&greenRow1Tex, &greenRow2Tex);
             player.loadMetaLabels("green");
-            cout << "[SELECT] GREEN Character!" << endl;
+            LOG_INFO("[SELECT] GREEN Character!");
 
             // Particle effect
             particles.emit(Vector2f(SCREEN_WIDTH / 2 + 200, 400), Color::Green, 20);
         }
-        if (enterNow && !enterPressed)
+        if (input.pressed(InputState::CONFIRM))
         {
-            menuMusic.stop();
+            if (menuMusic)
+                menuMusic->stop();
             startLevel(1);
         }
-
-        key1Pressed = key1Now;
-        key2Pressed = key2Now;
-        enterPressed = enterNow;
     }
 
     void startLevel(int level)
@@ -3253,7 +6466,9 @@ private:
         currentLevel = level;
         state = (level == 1) ? LEVEL_1 : LEVEL_2;
 
+        const LevelData &data = levelData(level);
         player.reset(level);
+        player.maxCapacity = data.capacity;
         enemies.clear();
         projectiles.clear();
         enemyProjectiles.clear();
@@ -3265,91 +6480,49 @@ private:
         else
             scoreManager.addCharacterBonus("Max Capacity");
 
+        acquireLevelTextures(data);
         buildLevel(level);
         spawnEnemies(level);
         spawnPowerups(level);
 
-        bgMusic.stop();
-        if (level == 1)
-        {
-            bgMusic.openFromFile("Data/Asset/mus.ogg");
-        }
-        else
-        {
-            bgMusic.openFromFile("Data/Asset/music_level2.ogg");
-        }
-        bgMusic.play();
+        // Start this level's track (opened in the background earlier) and queue
+        // the one the next transition will need (back to level 1's after the last)
+        bgMusic.play(data.music);
+        bgMusic.prefetch(level < (int)levels.size() ? levelData(level + 1).music : levels[0].music);
 
-        cout << "\n========== LEVEL " << level << " START! ==========\n"
-             << endl;
+        LOG_INFO("\n========== LEVEL " << level << " START! ==========\n");
+    }
+
+    // Takes references on the sheets this level needs before dropping the ones
+    // the previous level held, so a sheet shared by both is never reloaded
+    void acquireLevelTextures(const LevelData &data)
+    {
+        std::vector<std::string> needed;
+        if (data.background == 2)
+            needed.push_back("Data/Asset/bg_level2.png");
+        for (size_t i = 0; i < needed.size(); i++)
+        {
+            textureCache.acquire(needed[i]);
+            textureCache.load(needed[i]);
+        }
+        for (size_t i = 0; i < levelTextures.size(); i++)
+            textureCache.release(levelTextures[i]);
+        levelTextures.swap(needed);
+        LOG_DEBUG("[TEXTURES] " << textureCache.residentCount() << " resident, "
+                                << textureCache.getEvictionCount() << " evicted so far");
     }
 
     // Builds the level layout grid and visual background for the given level
     void buildLevel(int level)
     {
-        // Clear map and slope offsets before populating tiles
-        for (int i = 0; i < LEVEL_HEIGHT; i++)
-        {
-            for (int j = 0; j < LEVEL_WIDTH; j++)
-            {
-                levelMap[i][j] = ' ';
-                slopeOffset[i][j] = 0;
-            }
-        }
-
-        if (level == 1)
-        {
-            // Ground (row 13)
-            for (int j = 0; j < LEVEL_WIDTH; j++)
-                levelMap[13][j] = '#';
-
-            // Lower the next tiers to ease jumps and add a small center step
-            // Row 11 platforms (was 10)
-            for (int j = 2; j < 8; j++)
-                levelMap[11][j] = '#';
-            for (int j = 10; j < 16; j++)
-                levelMap[11][j] = '#';
-
-            // Row 8 platforms (was 7) with a center helper
-            for (int j = 1; j < 6; j++)
-                levelMap[8][j] = '#';
-            for (int j = 12; j < 17; j++)
-                levelMap[8][j] = '#';
-            for (int j = 8; j < 11; j++)
-                levelMap[8][j] = '#';
-
-            // Row 5 platform (was 4)
-            for (int j = 5; j < 13; j++)
-                levelMap[5][j] = '#';
+        // Copy the authored tiles and ramp offsets from the level file
+        const LevelData &data = levelData(level);
+        levelMap = data.map;
+        levelWidth = levelMap.width;
+        levelHeight = levelMap.height;
 
-            bgSprite.setTexture(bgTex);
-            bgSprite.setScale((float)SCREEN_WIDTH / bgTex.getSize().x,
-                              (float)SCREEN_HEIGHT / bgTex.getSize().y);
-        }
-        else
+        if (data.randomRamps)
         {
-            // Straight platforms with clean, equally spaced layers (vertical gap >= 90px)
-            for (int j = 0; j < LEVEL_WIDTH; j++)
-                levelMap[13][j] = '#';
-
-            for (int j = 0; j < 9; j++)
-                levelMap[11][j] = '#';
-            for (int j = 12; j < 15; j++)
-                levelMap[11][j] = '#';
-
-            for (int j = 3; j < 9; j++)
-                levelMap[8][j] = '#';
-            for (int j = 11; j < 18; j++)
-                levelMap[8][j] = '#';
-
-            for (int j = 5; j < 12; j++)
-                levelMap[5][j] = '#';
-
-            for (int j = 1; j < 4; j++)
-                levelMap[2][j] = '#';
-            for (int j = 14; j < 17; j++)
-                levelMap[2][j] = '#';
-
             // Slanted ramps: attach only to left/right edges, allowed angles ±30/±45
             auto attachRamp = [&](int row, int edgeCol, bool fromRightEdge, int tiles, int degrees)
             {
@@ -3361,26 +6534,26 @@ private:
                 {
                     int k = j - startCol;
                     int delta = (downRight ? +1 : -1) * (k * step);
-                    levelMap[row][j] = downRight ? '/' : '\\';
-                    slopeOffset[row][j] = delta;
+                    levelMap.at(row, j) = downRight ? '/' : '\\';
+                    levelMap.slopeAt(row, j) = delta;
                 }
                 // Trim the block adjoining the ramp so the surface remains continuous
-                if (!fromRightEdge && startCol - 1 >= 0 && levelMap[row][startCol - 1] == '#')
-                    levelMap[row][startCol - 1] = ' ';
-                if (fromRightEdge && endCol + 1 < LEVEL_WIDTH && levelMap[row][endCol + 1] == '#')
-                    levelMap[row][endCol + 1] = ' ';
+                if (!fromRightEdge && startCol - 1 >= 0 && levelMap.at(row, startCol - 1) == '#')
+                    levelMap.at(row, startCol - 1) = ' ';
+                if (fromRightEdge && endCol + 1 < levelWidth && levelMap.at(row, endCol + 1) == '#')
+                    levelMap.at(row, endCol + 1) = ' ';
             };
 
             auto collectSpans = [&](int r)
             {
                 std::vector<std::pair<int, int>> spans;
                 int c = 0;
-                while (c < LEVEL_WIDTH)
+                while (c < levelWidth)
                 {
-                    while (c < LEVEL_WIDTH && levelMap[r][c] != '#')
+                    while (c < levelWidth && levelMap.at(r, c) != '#')
                         ++c;
                     int a = c;
-                    while (c < LEVEL_WIDTH && levelMap[r][c] == '#')
+                    while (c < levelWidth && levelMap.at(r, c) == '#')
                         ++c;
                     int b = c - 1;
                     if (a <= b)
@@ -3393,11 +6566,11 @@ private:
             {
                 int startCol = fromRightEdge ? edgeCol + 1 : edgeCol - tiles;
                 int endCol = fromRightEdge ? edgeCol + tiles : edgeCol - 1;
-                if (startCol < 0 || endCol >= LEVEL_WIDTH)
+                if (startCol < 0 || endCol >= levelWidth)
                     return false;
                 for (int j = startCol; j <= endCol; ++j)
                 {
-                    if (levelMap[row][j] != ' ')
+                    if (levelMap.at(row, j) != ' ')
                         return false;
                 }
                 return true;
@@ -3406,23 +6579,25 @@ private:
             auto placeRandomRamps = [&]()
             {
                 int rows[] = {2, 5, 8, 11};
-                int target = 1 + (rand() % 4);
+                int target = 1 + rngLevel.below(4);
                 int attempts = 0;
                 int placed = 0;
                 while (placed < target && attempts < 100)
                 {
                     attempts++;
-                    int r = rows[rand() % 4];
+                    int r = rows[rngLevel.below(4)];
+                    if (r >= levelHeight)
+                        continue;
                     auto spans = collectSpans(r);
                     if (spans.empty())
                         continue;
-                    auto span = spans[rand() % spans.size()];
-                    bool fromRight = (rand() % 2) == 0;
+                    auto span = spans[rngLevel.below((int)spans.size())];
+                    bool fromRight = rngLevel.below(2) == 0;
                     int edgeCol = fromRight ? span.second : span.first;
                     int degOpt[2] = {45, 30};
-                    int degrees = degOpt[rand() % 2];
+                    int degrees = degOpt[rngLevel.below(2)];
                     int step = (degrees == 45) ? CELL_SIZE : (int)std::round(CELL_SIZE * 0.577f);
-                    int tiles = 3 + (rand() % 3);
+                    int tiles = 3 + rngLevel.below(3);
                     // Ensure ramp area is empty before placing slants
                     if (!canPlaceRamp(r, edgeCol, fromRight, tiles, step))
                         continue;
@@ -3432,12 +6607,77 @@ private:
             };
 
             placeRandomRamps();
+        }
+
+        if (data.background == 2 && sheetSize(bg2Tex).x > 0)
+        {
+            bgSprite.setTexture(bg2Tex);
+            bgSprite.setScale((float)SCREEN_WIDTH / sheetSize(bg2Tex).x,
+                              (float)SCREEN_HEIGHT / sheetSize(bg2Tex).y);
+        }
+        else
+        {
+            bgSprite.setTexture(bgTex);
+            bgSprite.setScale((float)SCREEN_WIDTH / sheetSize(bgTex).x,
+                              (float)SCREEN_HEIGHT / sheetSize(bgTex).y);
+        }
+
+        // Terrain is static for the rest of the level: bake it and the
+        // enemy navigation tables once here
+        tileGrid.build(levelMap);
+        platformGraph.build(tileGrid);
+        playerFlow.invalidate();
+        enemyGrid.resize(levelWidth, levelHeight);
+        enemyShotGrid.resize(levelWidth, levelHeight);
+        camera.setWorld((float)world_width(), (float)world_height());
+        build_tile_mesh(terrain, tileGrid, platformTex, CELL_SIZE);
+        buildRampMesh();
+        for (size_t i = 0; i < terrain.size(); i++)
+            terrain[i].updateBounds();
+    }
+
+    // Tessellates the 'S' staircase and every '/' '\\' run into the ramp layer of
+    // the chunk each strip starts in. Must be re-run whenever levelMap changes
+    // (only buildLevel does).
+    void buildRampMesh()
+    {
+        if (sheetSize(platformTex).x == 0)
+            return;
 
-            if (bg2Tex.getSize().x > 0)
+        float thick = (float)(int)(CELL_SIZE * 0.8f);
+        float texH = (float)sheetSize(platformTex).y;
+
+        // Pre-defined 'S' staircase
+        int sr = 4, sc = 12;
+        int er = 9, ec = 7;
+        if (levelMap.inside(sr, sc) && levelMap.inside(er, ec) &&
+            levelMap.at(sr, sc) == 'S' && levelMap.at(er, ec) == 'S')
+        {
+            append_ramp_strip(terrain[terrain_chunk(tileGrid, sr, sc)].ramps,
+                              (float)(sc * CELL_SIZE), (float)tileGrid.surfaceY(sr, sc),
+                              (float)(ec * CELL_SIZE), (float)tileGrid.surfaceY(er, ec),
+                              thick, texH);
+        }
+
+        // Randomized slants: one strip per contiguous run of the same slant
+        for (int i = 0; i < levelHeight; ++i)
+        {
+            int j = 0;
+            while (j < levelWidth)
             {
-                bgSprite.setTexture(bg2Tex);
-                bgSprite.setScale((float)SCREEN_WIDTH / bg2Tex.getSize().x,
-                                  (float)SCREEN_HEIGHT / bg2Tex.getSize().y);
+                char cell = levelMap.at(i, j);
+                if (cell == '/' || cell == '\\')
+                {
+                    int startCol = j;
+                    while (j + 1 < levelWidth && levelMap.at(i, j + 1) == cell)
+                        ++j;
+                    int endCol = j;
+                    append_ramp_strip(terrain[terrain_chunk(tileGrid, i, startCol)].ramps,
+                                      (float)(startCol * CELL_SIZE), (float)tileGrid.surfaceY(i, startCol),
+                                      (float)(endCol * CELL_SIZE), (float)tileGrid.surfaceY(i, endCol),
+                                      thick, texH);
+                }
+                ++j;
             }
         }
     }
@@ -3445,8 +6685,7 @@ private:
     // Spawns enemies for the level and initializes their sprites and placement
     void spawnEnemies(int level)
     {
-        cout << "Spawning Level " << level << " enemies...\n"
-             << endl;
+        LOG_INFO("Spawning Level " << level << " enemies...\n");
         enemies.clear();
 
         auto addEnemiesOnSegment = [&](int row, int cStart, int cEnd, int count, const vector<int> &types)
@@ -3468,9 +6707,9 @@ private:
                 {
                     for (size_t k = 0; k < enemies.size(); k++)
                     {
-                        if (fabs(enemies[k].y - baseY) < 8.0f)
+                        if (fabs(enemies.hot.y[k] - baseY) < 8.0f)
                         {
-                            if (fabs(enemies[k].x - xCandidate) < minSpacing)
+                            if (fabs(enemies.hot.x[k] - xCandidate) < minSpacing)
                                 return true;
                         }
                     }
@@ -3479,35 +6718,29 @@ private:
 
                 while (attempts < widthTiles && isTooClose(xPix))
                 {
-                    int offset = (rand() % 3) - 1;
+                    int offset = rngLevel.below(3) - 1;
                     tileCol = max(cStart, min(tileCol + offset, cEnd));
                     xPix = tileCol * CELL_SIZE + 8.0f;
                     attempts++;
                 }
 
                 int type = types[i % (int)types.size()];
-                enemies.push_back(Enemy(type, xPix, baseY));
+                enemies.spawn(type, xPix, baseY);
             }
         };
 
-        if (level == 1)
-        {
-            useWaveSpawning = false;
-            addEnemiesOnSegment(5, 5, 13, 3, {0});
-            addEnemiesOnSegment(8, 1, 6, 2, {0});
-            addEnemiesOnSegment(8, 12, 16, 2, {0});
-            addEnemiesOnSegment(11, 2, 7, 1, {0});
-            addEnemiesOnSegment(13, 1, 16, 2, {1});
-            addEnemiesOnSegment(11, 10, 15, 2, {1});
-        }
-        else
+        // Levels with waves count their initial spawn as wave 1
+        const LevelData &data = levelData(level);
+        useWaveSpawning = !data.waves.empty();
+        currentWave = 0;
+        waveDelay = 0.0f;
+        if (useWaveSpawning)
+            LOG_INFO("[WAVE 1] Spawning initial enemies...");
+        for (size_t i = 0; i < data.spawns.size(); i++)
         {
-            useWaveSpawning = true;
-            currentWave = 0;
-            waveDelay = 0.0f;
-            cout << "[WAVE 1] Spawning 3 Invisible Men..." << endl;
-            addEnemiesOnSegment(8, 4, 8, 2, {2});
-            addEnemiesOnSegment(12, 12, 16, 1, {2});
+            const LevelData::Segment &seg = data.spawns[i];
+            addEnemiesOnSegment(seg.row, seg.colStart, seg.colEnd, seg.count,
+                                vector<int>(seg.types, seg.types + seg.typeCount));
         }
 
         // Setup sprites for all enemies
@@ -3529,44 +6762,36 @@ private:
                 tex = &chelnovTex;
                 break;
             }
-            if (tex && tex->getSize().x > 0)
+            if (tex && sheetSize(*tex).x > 0)
                 enemies[i].setupSprite(*tex, (enemies[i].type == 2 ? &invisibleDimTex : nullptr));
-            enemies[i].checkPlatformCollision(mapPtr());
-            enemies[i].velocityY = 0;
-            enemies[i].onGround = true;
+            enemies.hot.collide(i, tileGrid);
+            enemies.hot.velocityY[i] = 0;
+            enemies.hot.onGround[i] = 1;
         }
 
-        cout << "[SPAWNED] " << enemies.size() << " enemies for Level " << level << endl;
+        LOG_INFO("[SPAWNED] " << enemies.size() << " enemies for Level " << level);
     }
 
     // Spawns a wave of enemies of a specific type and count
     void spawnWave(int type, int count)
     {
-        cout << "[WAVE] Spawning type " << type << " x" << count << endl;
-        vector<tuple<int, int, int>> segments;
-        segments.push_back({2, 1, 3});
-        segments.push_back({2, 14, 16});
-        segments.push_back({5, 5, 12});
-        segments.push_back({8, 2, 7});
-        segments.push_back({8, 10, 15});
-        segments.push_back({11, 3, 8});
-        segments.push_back({11, 9, 14});
-        segments.push_back({13, 1, 16});
+        LOG_INFO("[WAVE] Spawning type " << type << " x" << count);
+        const std::vector<LevelData::Segment> &segments = levelData(currentLevel).waveSegments;
 
         int placed = 0;
         int segIndex = 0;
         while (placed < count && !segments.empty())
         {
-            std::tuple<int, int, int> seg = segments[segIndex % segments.size()];
+            const LevelData::Segment &seg = segments[segIndex % segments.size()];
             segIndex++;
-            int row = std::get<0>(seg);
-            int cStart = std::get<1>(seg);
-            int cEnd = std::get<2>(seg);
+            int row = seg.row;
+            int cStart = seg.colStart;
+            int cEnd = seg.colEnd;
             int widthTiles = cEnd - cStart + 1;
             float baseY = row * CELL_SIZE - ENEMY_FRAME_HEIGHT * ENEMY_SCALE - 1;
             int minSpacing = 96;
 
-            float t = (float)((rand() % (widthTiles - 1)) + 1) / (float)(widthTiles);
+            float t = (float)(rngLevel.below(widthTiles - 1) + 1) / (float)(widthTiles);
             int tileCol = cStart + (int)round(t * (widthTiles - 1));
             tileCol = max(cStart, min(tileCol, cEnd));
             float xPix = tileCol * CELL_SIZE + 8.0f;
@@ -3575,9 +6800,9 @@ private:
             {
                 for (size_t k = 0; k < enemies.size(); k++)
                 {
-                    if (fabs(enemies[k].y - baseY) < 8.0f)
+                    if (fabs(enemies.hot.y[k] - baseY) < 8.0f)
                     {
-                        if (fabs(enemies[k].x - xCandidate) < minSpacing)
+                        if (fabs(enemies.hot.x[k] - xCandidate) < minSpacing)
                             return true;
                     }
                 }
@@ -3587,13 +6812,13 @@ private:
             int attempts = 0;
             while (attempts < widthTiles && isTooClose(xPix))
             {
-                int offset = (rand() % 3) - 1;
+                int offset = rngLevel.below(3) - 1;
                 tileCol = max(cStart, min(tileCol + offset, cEnd));
                 xPix = tileCol * CELL_SIZE + 8.0f;
                 attempts++;
             }
 
-            Enemy e(type, xPix, baseY);
+            Enemy &e = enemies.spawn(type, xPix, baseY);
             Texture *tex = nullptr;
             switch (type)
             {
@@ -3610,39 +6835,28 @@ private:
                 tex = &chelnovTex;
                 break;
             }
-            if (tex && tex->getSize().x > 0)
+            if (tex && sheetSize(*tex).x > 0)
                 e.setupSprite(*tex, (type == 2 ? &invisibleDimTex : nullptr));
-            e.checkPlatformCollision(mapPtr());
-            e.velocityY = 0;
-            e.onGround = true;
-            enemies.push_back(e);
+            enemies.hot.collide(e.id, tileGrid);
+            e.velocityY() = 0;
+            e.onGround() = 1;
             placed++;
         }
-        cout << "[WAVE] Spawned " << placed << " enemies" << endl;
+        LOG_INFO("[WAVE] Spawned " << placed << " enemies");
     }
 
     void spawnNextWave()
     {
         if (!useWaveSpawning)
             return;
-        if (currentWave >= 3)
+        const std::vector<LevelData::Wave> &waves = levelData(currentLevel).waves;
+        if (currentWave >= (int)waves.size())
             return;
+        const LevelData::Wave &wave = waves[currentWave];
         currentWave++;
-        if (currentWave == 1)
-        {
-            cout << "[WAVE 2] Spawning 4 Chelnov..." << endl;
-            spawnWave(3, 4);
-        }
-        else if (currentWave == 2)
-        {
-            cout << "[WAVE 3] Spawning 9 Skeletons..." << endl;
-            spawnWave(1, 9);
-        }
-        else if (currentWave == 3)
-        {
-            cout << "[WAVE 4] Spawning 4 Ghosts (Final Wave)..." << endl;
-            spawnWave(0, 4);
-        }
+        LOG_INFO("[WAVE " << currentWave + 1 << "] Spawning " << wave.count << " of type " << wave.type
+                          << (currentWave == (int)waves.size() ? " (Final Wave)..." : "..."));
+        spawnWave(wave.type, wave.count);
         waveDelay = 0.0f;
     }
 
@@ -3650,109 +6864,81 @@ private:
     {
         powerups.clear();
 
-        if (level == 1)
-        {
-            Powerup p1(POWERUP_SPEED, 500, 4 * CELL_SIZE - 16);
-            if (rollerSkatesTex.getSize().x > 0)
-                p1.setupSprite(rollerSkatesTex);
-            else if (powerupSpeedTex.getSize().x > 0)
-                p1.setupSprite(powerupSpeedTex);
-            if (!effectMetaRects["0"].empty())
-                p1.applyMetaRects(effectMetaRects["0"]);
-            powerups.push_back(p1);
-
-            Powerup p2(POWERUP_LIFE, 300, 7 * CELL_SIZE - 16);
-            if (flashTex.getSize().x > 0)
-                p2.setupSprite(flashTex);
-            else if (powerupLifeTex.getSize().x > 0)
-                p2.setupSprite(powerupLifeTex);
-            if (!effectMetaRects["3"].empty())
-                p2.applyMetaRects(effectMetaRects["3"]);
-            powerups.push_back(p2);
-        }
-        else
+        const LevelData &data = levelData(level);
+        for (size_t i = 0; i < data.powerups.size(); i++)
         {
-            Powerup p1(POWERUP_SPEED, 400, 5 * CELL_SIZE - 16);
-            if (rollerSkatesTex.getSize().x > 0)
-                p1.setupSprite(rollerSkatesTex);
-            else if (powerupSpeedTex.getSize().x > 0)
-                p1.setupSprite(powerupSpeedTex);
-            if (!effectMetaRects["0"].empty())
-                p1.applyMetaRects(effectMetaRects["0"]);
-            powerups.push_back(p1);
-
-            Powerup p2(POWERUP_RANGE, 600, 8 * CELL_SIZE - 16);
-            if (vacuumEffectTex.getSize().x > 0)
-                p2.setupSprite(vacuumEffectTex);
-            else if (powerupRangeTex.getSize().x > 0)
-                p2.setupSprite(powerupRangeTex);
-            if (!effectMetaRects["2"].empty())
-                p2.applyMetaRects(effectMetaRects["2"]);
-            powerups.push_back(p2);
-
-            Powerup p3(POWERUP_POWER, 350, 11 * CELL_SIZE - 16);
-            if (powTex.getSize().x > 0)
-                p3.setupSprite(powTex);
-            else if (powerupPowerTex.getSize().x > 0)
-                p3.setupSprite(powerupPowerTex);
-            if (!effectMetaRects["1"].empty())
-                p3.applyMetaRects(effectMetaRects["1"]);
-            powerups.push_back(p3);
-
-            Powerup p4(POWERUP_LIFE, 200, 2 * CELL_SIZE - 16);
-            if (flashTex.getSize().x > 0)
-                p4.setupSprite(flashTex);
-            else if (powerupLifeTex.getSize().x > 0)
-                p4.setupSprite(powerupLifeTex);
-            if (!effectMetaRects["3"].empty())
-                p4.applyMetaRects(effectMetaRects["3"]);
-            powerups.push_back(p4);
+            const LevelData::PowerupSpawn &spawn = data.powerups[i];
+            PowerupType type = (PowerupType)spawn.type;
+            Powerup p(type, (float)spawn.x, (float)(spawn.row * CELL_SIZE - 16));
+
+            // Animated effect sheet first, static icon as the fallback
+            Texture *sheet = &flashTex, *icon = &powerupLifeTex;
+            int clip = effectClips[3];
+            if (type == POWERUP_SPEED)
+            {
+                sheet = &rollerSkatesTex;
+                icon = &powerupSpeedTex;
+                clip = effectClips[0];
+            }
+            else if (type == POWERUP_RANGE)
+            {
+                sheet = &vacuumEffectTex;
+                icon = &powerupRangeTex;
+                clip = effectClips[2];
+            }
+            else if (type == POWERUP_POWER)
+            {
+                sheet = &powTex;
+                icon = &powerupPowerTex;
+                clip = effectClips[1];
+            }
+            if (sheetSize(*sheet).x > 0)
+                p.setupSprite(*sheet);
+            else if (sheetSize(*icon).x > 0)
+                p.setupSprite(*icon);
+            p.applyClip(clip);
+            powerups.push_back(p);
         }
     }
 
     void updateGameplay(float dt)
     {
+        ProfileScope scope(profiler, PROF_PLAYER);
         scoreManager.update(dt);
 
         // Restart
-        static bool rPressed = false;
-        bool rNow = Keyboard::isKeyPressed(Keyboard::R);
-        if (rNow && !rPressed)
+        if (input.pressed(InputState::RESTART))
         {
             startLevel(currentLevel);
-            rPressed = rNow;
             return;
         }
-        rPressed = rNow;
 
         // Movement
         player.velocityX = 0;
-        if (Keyboard::isKeyPressed(Keyboard::Left))
+        if (input.down(InputState::MOVE_LEFT))
         {
             player.velocityX = -player.speed;
             player.facingRight = false;
         }
-        if (Keyboard::isKeyPressed(Keyboard::Right))
+        if (input.down(InputState::MOVE_RIGHT))
         {
             player.velocityX = player.speed;
             player.facingRight = true;
         }
-        if (!Keyboard::isKeyPressed(Keyboard::Left) && !Keyboard::isKeyPressed(Keyboard::Right) && player.jumpBoostTimer > 0 && !player.onGround)
+        if (!input.down(InputState::MOVE_LEFT) && !input.down(InputState::MOVE_RIGHT) && player.jumpBoostTimer > 0 && !player.onGround)
         {
             player.velocityX = player.facingRight ? player.speed : -player.speed;
         }
 
         // Jump
-        static bool upPressed = false;
-        bool upNow = Keyboard::isKeyPressed(Keyboard::Up);
-        if (upNow && !upPressed && player.onGround)
+        if (input.pressed(InputState::JUMP) && player.onGround)
         {
             player.velocityY = JUMP_STRENGTH;
             player.onGround = false;
 
             // User requested: "move him little forward in that direction"
-            bool leftNow = Keyboard::isKeyPressed(Keyboard::Left);
-            bool rightNow = Keyboard::isKeyPressed(Keyboard::Right);
+            bool leftNow = input.down(InputState::MOVE_LEFT);
+            bool rightNow = input.down(InputState::MOVE_RIGHT);
 
             float forwardBoost = 18.0f;
             if (rightNow || (player.facingRight && !leftNow))
@@ -3771,12 +6957,11 @@ private:
             jumpGuiding = false;
             if (player.x < 0)
                 player.x = 0;
-            if (player.x > SCREEN_WIDTH - player.getWidth())
-                player.x = SCREEN_WIDTH - player.getWidth();
+            if (player.x > world_width() - player.getWidth())
+                player.x = world_width() - player.getWidth();
             particles.emit(Vector2f(player.getCenterX(), player.y + player.getHeight()),
                            Color(200, 200, 200), 8);
         }
-        upPressed = upNow;
         if (player.jumpBoostTimer > 0)
         {
             player.jumpBoostTimer -= dt;
@@ -3784,7 +6969,7 @@ private:
         }
 
         // Crouch
-        if (Keyboard::isKeyPressed(Keyboard::Down) && player.onGround)
+        if (input.down(InputState::DROP) && player.onGround)
         {
             player.velocityX = 0;
             player.animState = P_CROUCH;
@@ -3792,10 +6977,10 @@ private:
         }
 
         // Vacuum direction (WASD): 0=Right, 1=Up, 2=Left, 3=Down
-        bool dirRight = Keyboard::isKeyPressed(Keyboard::D);
-        bool dirUp = Keyboard::isKeyPressed(Keyboard::W);
-        bool dirLeft = Keyboard::isKeyPressed(Keyboard::A);
-        bool dirDown = Keyboard::isKeyPressed(Keyboard::S);
+        bool dirRight = input.down(InputState::AIM_RIGHT);
+        bool dirUp = input.down(InputState::AIM_UP);
+        bool dirLeft = input.down(InputState::AIM_LEFT);
+        bool dirDown = input.down(InputState::AIM_DOWN);
         if (dirRight)
             player.vacuumDirection = 0;
         else if (dirUp)
@@ -3813,7 +6998,7 @@ private:
         }
 
         // Vacuum activation
-        player.vacuumActive = Keyboard::isKeyPressed(Keyboard::Space);
+        player.vacuumActive = input.down(InputState::VACUUM);
         player.shootHold = player.vacuumActive;
 
         // Update Vacuum Animation State Machine
@@ -3886,20 +7071,15 @@ private:
             player.animStateTimer = 0;
         }
 
-        // Single shot (Z) - spawn one projectile from captured enemies
-        static bool zPressed = false;
-        bool zNow = Keyboard::isKeyPressed(Keyboard::Z);
-        if (zNow && !zPressed && shootCooldown <= 0)
+        // Single shot (Z) - spawn one projectile from captured enemies (only
+        // when the pool has room, so a capture is never spent on a dropped shot)
+        if (input.pressed(InputState::SHOOT) && shootCooldown <= 0 && projectiles.room() > 0)
         {
             int type = player.releaseOneEnemy();
             if (type >= 0)
             {
                 int dirNow = player.vacuumDirection;
-                bool aimRight = Keyboard::isKeyPressed(Keyboard::D);
-                bool aimUp = Keyboard::isKeyPressed(Keyboard::W);
-                bool aimLeft = Keyboard::isKeyPressed(Keyboard::A);
-                bool aimDown = Keyboard::isKeyPressed(Keyboard::S);
-                if (!aimRight && !aimUp && !aimLeft && !aimDown)
+                if (!input.aiming())
                     // Default to facing horizontal if no aim key is held
                     dirNow = player.facingRight ? 0 : 2;
 
@@ -3971,7 +7151,7 @@ private:
                         p.velocityX = 0;
                     }
                 }
-                projectiles.push_back(p);
+                projectiles.spawn(std::move(p));
 
                 player.vacuumDirection = dirNow;
                 vacuumTrailTimer = 0.25f;
@@ -3985,22 +7165,20 @@ private:
                 particles.emit(Vector2f(player.getCenterX(), player.getCenterY()),
                                Color::Cyan, 15);
 
-                cout << "[SHOT] Single shot! Type: " << type << " ["
-                     << player.capturedCount << "/" << player.maxCapacity << "]" << endl;
+                LOG_DEBUG("[SHOT] Single shot! Type: " << type << " ["
+                          << player.capturedCount << "/" << player.maxCapacity << "]");
                 createSuperWaveEffect();
                 vacuumSuppressTimer = 0.0f;
             }
             else
             {
-                cout << "[SHOT] No enemies to shoot!" << endl;
+                LOG_DEBUG("[SHOT] No enemies to shoot!");
             }
         }
-        zPressed = zNow;
 
-        // Burst shot (X)
-        static bool xPressed = false;
-        bool xNow = Keyboard::isKeyPressed(Keyboard::X);
-        if (xNow && !xPressed && burstCooldown <= 0 && player.capturedCount > 0)
+        // Burst shot (X); needs room for every captured enemy before releasing them
+        if (input.pressed(InputState::BURST) && burstCooldown <= 0 && player.capturedCount > 0 &&
+            projectiles.room() >= (size_t)player.capturedCount)
         {
             int types[5];
             int count;
@@ -4010,11 +7188,7 @@ private:
                 scoreManager.addVacuumBurstBonus(count);
 
             int dirNow = player.vacuumDirection;
-            bool aimRight = Keyboard::isKeyPressed(Keyboard::D);
-            bool aimUp = Keyboard::isKeyPressed(Keyboard::W);
-            bool aimLeft = Keyboard::isKeyPressed(Keyboard::A);
-            bool aimDown = Keyboard::isKeyPressed(Keyboard::S);
-            if (!aimRight && !aimUp && !aimLeft && !aimDown)
+            if (!input.aiming())
                 dirNow = player.facingRight ? 0 : 2;
 
             float cx = player.getCenterX();
@@ -4087,7 +7261,7 @@ private:
                         p.velocityX = 0;
                     }
                 }
-                projectiles.push_back(p);
+                projectiles.spawn(std::move(p));
             }
 
             burstCooldown = 1.5f;
@@ -4099,14 +7273,13 @@ private:
             particles.emit(Vector2f(player.getCenterX(), player.getCenterY()),
                            Color::Yellow, 30);
 
-            cout << "[BURST] " << count << " enemies released!" << endl;
+            LOG_DEBUG("[BURST] " << count << " enemies released!");
             createSuperWaveEffect();
             vacuumTrailTimer = 0.25f;
             player.vacuumDirection = dirNow;
 
             vacuumSuppressTimer = 0.0f;
         }
-        xPressed = xNow;
 
         if (vacuumTrailTimer > 0)
             vacuumTrailTimer -= dt;
@@ -4120,16 +7293,47 @@ private:
         }
 
         // Update player
-        player.update(dt, mapPtr());
+        player.update(dt, tileGrid);
+
+        scope.next(PROF_ENEMIES);
+        // Re-route the shared pursuit field when the player lands on a new platform
+        if (player.onGround)
+        {
+            int footRow = (int)((player.y + player.getHeight() + 2) / CELL_SIZE);
+            int footCol = (int)(player.getCenterX() / CELL_SIZE);
+            playerFlow.retarget(platformGraph, platformGraph.segmentAt(footRow, footCol));
+        }
+
+        // Enemies outside the chunks around the camera update only on every
+        // FAR_SIM_STRIDE-th tick (staggered by index) with a matching dt;
+        // EnemyMotion::integrate() substeps their motion so physics stays consistent
+        camera.follow(player.getCenterX(), player.getCenterY());
+        simTicks++;
+        int chunkPx = CHUNK_CELLS * CELL_SIZE;
+        FloatRect view = camera.bounds();
+        int nearC0 = (int)std::floor(view.left / chunkPx) - 1;
+        int nearC1 = (int)std::floor((view.left + view.width) / chunkPx) + 1;
+        int nearR0 = (int)std::floor(view.top / chunkPx) - 1;
+        int nearR1 = (int)std::floor((view.top + view.height) / chunkPx) + 1;
 
         // Update enemies and handle shooting
         for (size_t i = 0; i < enemies.size(); i++)
         {
             Enemy &enemy = enemies[i];
-            if (!enemy.active || enemy.captured)
+            if (!enemies.hot.live(i))
                 continue;
 
-            enemy.update(dt, mapPtr(), player.getCenterX(), player.getCenterY());
+            float enemyDt = dt;
+            int chunkC = (int)std::floor(enemy.getCenterX() / chunkPx);
+            int chunkR = (int)std::floor(enemy.getCenterY() / chunkPx);
+            if (chunkC < nearC0 || chunkC > nearC1 || chunkR < nearR0 || chunkR > nearR1)
+            {
+                if ((simTicks + i) % FAR_SIM_STRIDE != 0)
+                    continue;
+                enemyDt = dt * FAR_SIM_STRIDE;
+            }
+
+            enemy.update(enemyDt, player.getCenterX(), player.getCenterY());
 
             if (enemy.type == 2)
             {
@@ -4144,12 +7348,12 @@ private:
                 enemy.hasFired = true;
                 EnemyProjectile ep(enemy.getCenterX(), enemy.getCenterY(),
                                    player.getCenterX(), player.getCenterY());
-                if (currentLevel == 2 && bombBlueTex.getSize().x > 0)
+                if (levelData(currentLevel).blueBombs && sheetSize(bombBlueTex).x > 0)
                 {
                     ep.sprite.setTexture(bombBlueTex);
                     ep.frames = 7;
-                    int fw = bombBlueTex.getSize().x / ep.frames;
-                    int fh = bombBlueTex.getSize().y;
+                    int fw = sheetSize(bombBlueTex).x / ep.frames;
+                    int fh = sheetSize(bombBlueTex).y;
                     ep.sprite.setTextureRect(IntRect(0, 0, fw, fh));
                     ep.sprite.setScale(PROJECTILE_SCALE, PROJECTILE_SCALE);
                     ep.sprite.setPosition(ep.x - (fw * PROJECTILE_SCALE) / 2.0f,
@@ -4158,12 +7362,12 @@ private:
                     ep.texH = fh;
                     ep.hasTexture = true;
                 }
-                else if (bombRedTex.getSize().x > 0)
+                else if (sheetSize(bombRedTex).x > 0)
                 {
                     ep.sprite.setTexture(bombRedTex);
                     ep.frames = 7;
-                    int fw = bombRedTex.getSize().x / ep.frames;
-                    int fh = bombRedTex.getSize().y;
+                    int fw = sheetSize(bombRedTex).x / ep.frames;
+                    int fh = sheetSize(bombRedTex).y;
                     ep.sprite.setTextureRect(IntRect(0, 0, fw, fh));
                     ep.sprite.setScale(PROJECTILE_SCALE, PROJECTILE_SCALE);
                     ep.sprite.setPosition(ep.x - (fw * PROJECTILE_SCALE) / 2.0f,
@@ -4172,8 +7376,8 @@ private:
                     ep.texH = fh;
                     ep.hasTexture = true;
                 }
-                enemyProjectiles.push_back(ep);
-                cout << "[CHELNOV] Shooting projectile!" << endl;
+                enemyProjectiles.spawn(std::move(ep));
+                LOG_DEBUG("[CHELNOV] Shooting projectile!");
             }
 
             if (enemy.type == 0 && enemy.isShooting && enemy.actionTimer > 0.15f &&
@@ -4182,12 +7386,12 @@ private:
                 enemy.hasFired = true;
                 EnemyProjectile ep(enemy.getCenterX(), enemy.getCenterY(),
                                    player.getCenterX(), player.getCenterY());
-                if (bombRedTex.getSize().x > 0)
+                if (sheetSize(bombRedTex).x > 0)
                 {
                     ep.sprite.setTexture(bombRedTex);
                     ep.frames = 7;
-                    int fw = bombRedTex.getSize().x / ep.frames;
-                    int fh = bombRedTex.getSize().y;
+                    int fw = sheetSize(bombRedTex).x / ep.frames;
+                    int fh = sheetSize(bombRedTex).y;
                     ep.sprite.setTextureRect(IntRect(0, 0, fw, fh));
                     ep.sprite.setScale(PROJECTILE_SCALE, PROJECTILE_SCALE);
                     ep.sprite.setPosition(ep.x - (fw * PROJECTILE_SCALE) / 2.0f,
@@ -4196,8 +7400,8 @@ private:
                     ep.texH = fh;
                     ep.hasTexture = true;
                 }
-                enemyProjectiles.push_back(ep);
-                cout << "[GHOST] Spit projectile!" << endl;
+                enemyProjectiles.spawn(std::move(ep));
+                LOG_DEBUG("[GHOST] Spit projectile!");
             }
 
             // Skeleton head throw projectile
@@ -4208,12 +7412,12 @@ private:
                 EnemyProjectile ep(enemy.getCenterX(), enemy.getCenterY(),
                                    player.getCenterX(), player.getCenterY());
                 ep.frames = 1;
-                if (skeletonTex.getSize().x > 0)
+                if (sheetSize(skeletonTex).x > 0)
                 {
                     ep.sprite.setTexture(skeletonTex);
-                    int framesInRow = max(1, (int)(skeletonTex.getSize().x / ENEMY_FRAME_WIDTH));
-                    int fw = skeletonTex.getSize().x / framesInRow;
-                    int fh = skeletonTex.getSize().y;
+                    int framesInRow = max(1, (int)(sheetSize(skeletonTex).x / ENEMY_FRAME_WIDTH));
+                    int fw = sheetSize(skeletonTex).x / framesInRow;
+                    int fh = sheetSize(skeletonTex).y;
                     int windupStart = max(7, framesInRow / 3);
                     int headIndex = min(framesInRow - 1, windupStart + 2);
                     ep.sprite.setTextureRect(IntRect(headIndex * fw, 0, fw, fh));
@@ -4224,8 +7428,8 @@ private:
                     ep.texH = fh;
                     ep.hasTexture = true;
                 }
-                enemyProjectiles.push_back(ep);
-                cout << "[SKELETON] Threw head projectile!" << endl;
+                enemyProjectiles.spawn(std::move(ep));
+                LOG_DEBUG("[SKELETON] Threw head projectile!");
             }
 
             // Vacuum suction
@@ -4237,7 +7441,7 @@ private:
                     enemy.pullTowards(player.getCenterX(), player.getCenterY(), player.vacuumPower);
 
                     // Vacuum particle effect
-                    if (rand() % 3 == 0)
+                    if (rngFx.below(3) == 0)
                     {
                         particles.emit(Vector2f(enemy.getCenterX(), enemy.getCenterY()),
                                        Color(150, 150, 255), 3);
@@ -4267,11 +7471,9 @@ private:
                     }
                     if (enemy.type == 1)
                     {
-                        auto itCap = enemy.metaLabels.find("capture");
-                        if (itCap != enemy.metaLabels.end())
+                        int s, e;
+                        if (enemy.meta->labels.find(ANIM_CAPTURE, s, e))
                         {
-                            int s = itCap->second.first;
-                            int e = itCap->second.second;
                             enemy.animRow = 0;
                             enemy.seqStart = s;
                             enemy.animFrames = std::max(1, e - s + 1);
@@ -4288,8 +7490,8 @@ private:
                             }
                             else
                             {
-                                enemy.captured = true;
-                                enemy.active = false;
+                                enemy.captured() = true;
+                                enemy.active() = false;
                                 player.captureEnemy(enemy.type);
                                 scoreManager.addCapturePoints(enemy.capturePoints, player.capturedCount);
 
@@ -4306,7 +7508,7 @@ private:
             {
                 FloatRect hb = player.getHitbox();
                 int pRow = (int)((player.y + player.getHeight()) / CELL_SIZE);
-                int eRow = (int)((enemy.y + enemy.getHeight()) / CELL_SIZE);
+                int eRow = (int)((enemy.y() + enemy.getHeight()) / CELL_SIZE);
                 bool canHitByRow = (enemy.type == 3) || (abs(pRow - eRow) <= 1);
                 if (canHitByRow && enemy.collidesWith(hb.left, hb.top, (int)hb.width, (int)hb.height))
                 {
@@ -4324,7 +7526,7 @@ private:
                     particles.emit(Vector2f(player.getCenterX(), player.getCenterY()),
                                    Color::Red, 25);
 
-                    cout << "[DAMAGE] Player hit! Health: " << player.health << endl;
+                    LOG_INFO("[DAMAGE] Player hit! Health: " << player.health);
 
                     if (player.health <= 0)
                     {
@@ -4332,59 +7534,91 @@ private:
                         player.animState = P_DEATH_FADE;
                         player.animStateTimer = 0;
                         deathTimer = 1.2f;
-                        cout << "[DEFEAT] Player dying animation" << endl;
+                        LOG_INFO("[DEFEAT] Player dying animation");
                     }
                 }
             }
         }
 
+        // Gravity, motion and tile collision for the enemies the AI stepped
+        EnemyMotion &hot = enemies.hot;
+        hot.integrate(tileGrid);
+
+        scope.next(PROF_SEPARATION);
         // Enemy separation to prevent overlap on same row
-        for (size_t i = 0; i < enemies.size(); i++)
+        float maxEnemyW = rebuildEnemyGrid();
+        std::vector<float> &ex = hot.x;
+        std::vector<float> &evx = hot.velocityX;
+        const std::vector<float> &ew = hot.width;
+        for (size_t i = 0; i < hot.size(); i++)
         {
-            Enemy &a = enemies[i];
-            if (!a.active || a.captured)
+            if (!hot.live(i))
                 continue;
-            for (size_t j = i + 1; j < enemies.size(); j++)
+            // Anything that can overlap i horizontally on its foot row. The grid
+            // holds positions from before this pass; the 2*maxEnemyW pad still
+            // finds a partner that has been pushed less than about that far since.
+            // A crowd dense enough to push one further can miss a pair this tick,
+            // and the next tick's rebuilt grid picks it up.
+            int aRow = hot.footRow(i);
+            float top = std::min(hot.y[i], (float)(aRow * CELL_SIZE));
+            float bottom = std::max(hot.y[i] + hot.height[i], (float)((aRow + 1) * CELL_SIZE));
+            enemyGrid.query(FloatRect(ex[i] - 2 * maxEnemyW, top, ew[i] + 4 * maxEnemyW, bottom - top), gridHits);
+            for (size_t h = 0; h < gridHits.size(); h++)
             {
-                Enemy &b = enemies[j];
-                if (!b.active || b.captured)
+                size_t j = (size_t)gridHits[h];
+                if (j <= i || !hot.live(j))
                     continue;
-                int aRow = (int)((a.y + a.getHeight()) / CELL_SIZE);
-                int bRow = (int)((b.y + b.getHeight()) / CELL_SIZE);
-                if (aRow != bRow)
+                if (aRow != hot.footRow(j))
                     continue;
-                float minGap = (a.getWidth() + b.getWidth()) * 0.5f;
-                float dx = (a.x + a.getWidth() * 0.5f) - (b.x + b.getWidth() * 0.5f);
+                float minGap = (ew[i] + ew[j]) * 0.5f;
+                float dx = (ex[i] + ew[i] * 0.5f) - (ex[j] + ew[j] * 0.5f);
                 float overlap = minGap - fabs(dx);
                 if (overlap > 0)
                 {
                     float push = overlap * 0.5f;
                     if (dx > 0)
                     {
-                        a.x += push;
-                        b.x -= push;
-                        a.velocityX = fabs(a.velocityX);
-                        b.velocityX = -fabs(b.velocityX);
+                        ex[i] += push;
+                        ex[j] -= push;
+                        evx[i] = fabs(evx[i]);
+                        evx[j] = -fabs(evx[j]);
                     }
                     else
                     {
-                        a.x -= push;
-                        b.x += push;
-                        a.velocityX = -fabs(a.velocityX);
-                        b.velocityX = fabs(b.velocityX);
+                        ex[i] -= push;
+                        ex[j] += push;
+                        evx[i] = -fabs(evx[i]);
+                        evx[j] = fabs(evx[j]);
                     }
                 }
             }
         }
 
-        // Update enemy projectiles
+        // Sprites follow the settled positions
+        for (size_t i = 0; i < enemies.size(); i++)
+        {
+            if (hot.live(i))
+                enemies[i].placeSprite();
+        }
+
+        scope.next(PROF_ENEMY_SHOTS);
+        // Update enemy projectiles, then test only the ones near the player
+        enemyShotGrid.clear();
         for (size_t i = 0; i < enemyProjectiles.size(); i++)
         {
             EnemyProjectile &ep = enemyProjectiles[i];
             if (!ep.active)
                 continue;
-
             ep.update(dt);
+            if (ep.active)
+                enemyShotGrid.insert((int)i, FloatRect(ep.x, ep.y, 16, 16));
+        }
+        enemyShotGrid.query(player.getHitbox(), gridHits);
+        for (size_t h = 0; h < gridHits.size(); h++)
+        {
+            EnemyProjectile &ep = enemyProjectiles[gridHits[h]];
+            if (!ep.active)
+                continue;
 
             if (iframeTimer <= 0)
             {
@@ -4404,9 +7638,9 @@ private:
                     particles.emit(Vector2f(player.getCenterX(), player.getCenterY()),
                                    Color::Red, 25);
 
-                    cout << "[DAMAGE] Hit by projectile! Health: " << player.health << endl;
+                    LOG_INFO("[DAMAGE] Hit by projectile! Health: " << player.health);
 
-                    if (impactTex.getSize().x > 0)
+                    if (sheetSize(impactTex).x > 0)
                     {
                         createImpactEffect(player.getCenterX(), player.getCenterY());
                     }
@@ -4417,13 +7651,15 @@ private:
                         player.animState = P_DEATH_FADE;
                         player.animStateTimer = 0;
                         deathTimer = 1.2f;
-                        cout << "[DEFEAT] Player dying animation (projectile)" << endl;
+                        LOG_INFO("[DEFEAT] Player dying animation (projectile)");
                     }
                 }
             }
         }
 
+        scope.next(PROF_PROJECTILES);
         // Update player projectiles
+        rebuildEnemyGrid();
         int defeatedThisFrame = 0;
         for (size_t i = 0; i < projectiles.size(); i++)
         {
@@ -4431,7 +7667,7 @@ private:
             if (!proj.active)
                 continue;
 
-            proj.update(dt, mapPtr());
+            proj.update(dt, tileGrid);
 
             if (iframeTimer <= 0 && proj.isRolling)
             {
@@ -4447,7 +7683,7 @@ private:
                     player.animStateTimer = 0;
                     particles.emit(Vector2f(player.getCenterX(), player.getCenterY()),
                                    Color::Red, 25);
-                    if (impactTex.getSize().x > 0)
+                    if (sheetSize(impactTex).x > 0)
                         createImpactEffect(player.getCenterX(), player.getCenterY());
                     if (player.health <= 0)
                     {
@@ -4459,13 +7695,15 @@ private:
                 }
             }
 
-            for (size_t j = 0; j < enemies.size(); j++)
+            enemyGrid.query(FloatRect(proj.x, proj.y, (float)proj.getSize(), (float)proj.getSize()), gridHits);
+            for (size_t h = 0; h < gridHits.size(); h++)
             {
+                size_t j = (size_t)gridHits[h];
                 if (proj.collidesWith(enemies[j]))
                 {
                     if (enemies[j].type == 1)
                         createSkeletonHitEffect(enemies[j].getCenterX(), enemies[j].getCenterY());
-                    enemies[j].active = false;
+                    enemies[j].active() = false;
                     proj.active = false;
                     defeatedThisFrame++;
 
@@ -4476,18 +7714,18 @@ private:
                     if (proj.isAerial())
                     {
                         scoreManager.addAerialBonus();
-                        cout << "[AERIAL BONUS] +150 points!" << endl;
+                        LOG_DEBUG("[AERIAL BONUS] +150 points!");
                     }
 
                     scoreManager.addDefeatPoints(enemies[j].capturePoints);
-                    cout << "[DEFEATED] Enemy type " << enemies[j].type
-                         << " (" << enemies[j].capturePoints * 2 << " points)" << endl;
+                    LOG_DEBUG("[DEFEATED] Enemy type " << enemies[j].type
+                              << " (" << enemies[j].capturePoints * 2 << " points)");
 
-                    if (flashTex.getSize().x > 0)
+                    if (sheetSize(flashTex).x > 0)
                     {
                         createFlashEffect(enemies[j].getCenterX(), enemies[j].getCenterY());
                     }
-                    if (debrisTex.getSize().x > 0)
+                    if (sheetSize(debrisTex).x > 0)
                     {
                         createDebrisEffect(enemies[j].getCenterX(), enemies[j].getCenterY());
                     }
@@ -4526,9 +7764,10 @@ private:
         if (defeatedThisFrame >= 2)
         {
             scoreManager.addMultiKillBonus(defeatedThisFrame);
-            cout << "[MULTI-KILL] " << defeatedThisFrame << " enemies! Bonus awarded." << endl;
+            LOG_DEBUG("[MULTI-KILL] " << defeatedThisFrame << " enemies! Bonus awarded.");
         }
 
+        scope.next(PROF_POWERUPS);
         // Update powerups
         for (size_t i = 0; i < powerups.size(); i++)
         {
@@ -4564,13 +7803,13 @@ private:
                     }
                     particles.emit(Vector2f(pu.x + 24, pu.y + 24), pColor, 25);
 
-                    cout << "[POWERUP] Collected powerup type: " << pu.type << endl;
+                    LOG_DEBUG("[POWERUP] Collected powerup type: " << pu.type);
 
-                    if (mysteryBoxTex.getSize().x > 0)
+                    if (sheetSize(mysteryBoxTex).x > 0)
                     {
                         createMysteryBoxEffect(pu.x, pu.y);
                     }
-                    if (pu.type == POWERUP_POWER && vacuumEffectTex.getSize().x > 0)
+                    if (pu.type == POWERUP_POWER && sheetSize(vacuumEffectTex).x > 0)
                     {
                         createVacuumPickupEffect(pu.x + 24, pu.y + 24);
                     }
@@ -4578,6 +7817,7 @@ private:
             }
         }
 
+        scope.next(PROF_EFFECTS);
         // Update effects (dt-based)
         for (size_t i = 0; i < effects.size(); i++)
         {
@@ -4591,11 +7831,12 @@ private:
 
             float limit = (float)e.frames / e.fps;
             e.index = min(e.frames - 1, (int)(e.timer * e.fps));
-            if (!e.customRects.empty())
+            const std::vector<IntRect> &clipFrames = AnimClipRegistry::shared().frames(e.clip);
+            if (!clipFrames.empty())
             {
-                int count = (int)e.customRects.size();
+                int count = (int)clipFrames.size();
                 e.index = std::min(count - 1, e.index);
-                e.sprite.setTextureRect(e.customRects[e.index]);
+                e.sprite.setTextureRect(clipFrames[e.index]);
             }
             else
             {
@@ -4608,11 +7849,13 @@ private:
                 e.active = false;
         }
 
+        scope.stop();
+
         // Level completion logic - only count active enemies NOT in inventory
         int activeEnemiesOnScreen = 0;
         for (size_t i = 0; i < enemies.size(); i++)
         {
-            if (enemies[i].active && !enemies[i].captured)
+            if (enemies.hot.live(i))
             {
                 activeEnemiesOnScreen++;
             }
@@ -4625,14 +7868,14 @@ private:
         debugTimer += dt;
         if (debugTimer > 3.0f)
         {
-            cout << "[STATUS] Active on-screen: " << activeEnemiesOnScreen
-                 << " | In inventory: " << player.capturedCount
-                 << " | Total remaining: " << totalRemaining << endl;
+            LOG_DEBUG("[STATUS] Active on-screen: " << activeEnemiesOnScreen
+                      << " | In inventory: " << player.capturedCount
+                      << " | Total remaining: " << totalRemaining);
             debugTimer = 0;
         }
 
         // Wave spawning system for Level 2
-        if (useWaveSpawning && currentLevel == 2 && currentWave < 3)
+        if (useWaveSpawning && currentWave < (int)levelData(currentLevel).waves.size())
         {
             if (activeEnemiesOnScreen == 0)
             {
@@ -4646,38 +7889,36 @@ private:
         // Level completes when NO active enemies remain on screen
         if (totalRemaining == 0)
         {
-            cout << "\n*** LEVEL " << currentLevel << " COMPLETED! ***" << endl;
-            cout << "Final Score: " << scoreManager.score << endl;
-            cout << "Level Time: " << scoreManager.levelTime << " seconds" << endl;
-            cout << "No Damage Bonus: " << (scoreManager.noDamage ? "YES" : "NO") << endl;
+            LOG_INFO("\n*** LEVEL " << currentLevel << " COMPLETED! ***");
+            LOG_INFO("Final Score: " << scoreManager.score);
+            LOG_INFO("Level Time: " << scoreManager.levelTime << " seconds");
+            LOG_INFO("No Damage Bonus: " << (scoreManager.noDamage ? "YES" : "NO"));
 
             scoreManager.levelComplete(currentLevel);
 
             // Level completion particle celebration
             for (int i = 0; i < 100; i++)
             {
-                float x = rand() % SCREEN_WIDTH;
-                float y = rand() % SCREEN_HEIGHT;
+                float x = rngFx.below(SCREEN_WIDTH);
+                float y = rngFx.below(SCREEN_HEIGHT);
                 Color colors[] = {Color::Yellow, Color::Cyan, Color::Magenta, Color::Green};
-                particles.emit(Vector2f(x, y), colors[rand() % 4], 5);
+                particles.emit(Vector2f(x, y), colors[rngFx.below(4)], 5);
             }
 
-            if (currentLevel == 1)
+            if (useWaveSpawning && currentWave < (int)levelData(currentLevel).waves.size())
+            {
+                return;
+            }
+            if (currentLevel < (int)levels.size())
             {
-                cout << "\n========== TRANSITIONING TO LEVEL 2 ==========\n"
-                     << endl;
-                cout << "Bonus awarded for Level 1 completion!" << endl;
-                startLevel(2);
+                LOG_INFO("\n========== TRANSITIONING TO LEVEL " << currentLevel + 1 << " ==========\n");
+                LOG_INFO("Bonus awarded for Level " << currentLevel << " completion!");
+                startLevel(currentLevel + 1);
             }
             else
             {
-                if (currentLevel == 2 && useWaveSpawning && currentWave < 3)
-                {
-                    return;
-                }
-                cout << "\n========== VICTORY! ALL LEVELS COMPLETED ==========\n"
-                     << endl;
-                cout << "Final Score with bonuses: " << scoreManager.score << endl;
+                LOG_INFO("\n========== VICTORY! ALL LEVELS COMPLETED ==========\n");
+                LOG_INFO("Final Score with bonuses: " << scoreManager.score);
                 state = VICTORY;
                 bgMusic.stop();
             }
@@ -4686,44 +7927,32 @@ private:
 
     void updateGameOver()
     {
-        static bool rPressed = false;
-        bool rNow = Keyboard::isKeyPressed(Keyboard::R);
-        if (rNow && !rPressed)
+        if (input.pressed(InputState::RESTART))
         {
             scoreManager.reset();
             state = CHARACTER_SELECT;
             bgSprite.setTexture(bgTex);
-            bgSprite.setScale((float)SCREEN_WIDTH / bgTex.getSize().x,
-                              (float)SCREEN_HEIGHT / bgTex.getSize().y);
-            menuMusic.play();
+            bgSprite.setScale((float)SCREEN_WIDTH / sheetSize(bgTex).x,
+                              (float)SCREEN_HEIGHT / sheetSize(bgTex).y);
+            if (menuMusic)
+                menuMusic->play();
         }
-        rPressed = rNow;
     }
 
     int bestPlatformRow()
     {
         int bestRow = -1;
         int bestCount = -1;
-        for (int r = 0; r < LEVEL_HEIGHT; r++)
+        for (int r = 0; r < levelHeight; r++)
         {
-            bool hasPlatform = false;
-            for (int c = 0; c < LEVEL_WIDTH; c++)
-            {
-                if (levelMap[r][c] == '#')
-                {
-                    hasPlatform = true;
-                    break;
-                }
-            }
-            if (!hasPlatform)
+            if (!tileGrid.any(r, 0, levelWidth - 1, TILE_SOLID))
                 continue;
             int cnt = 0;
             for (size_t i = 0; i < enemies.size(); i++)
             {
-                Enemy &e = enemies[i];
-                if (!e.active || e.captured)
+                if (!enemies.hot.live(i))
                     continue;
-                int eRow = (int)((e.y + e.getHeight()) / CELL_SIZE);
+                int eRow = enemies.hot.footRow(i);
                 if (eRow == r)
                     cnt++;
             }
@@ -4752,9 +7981,9 @@ private:
         sw.sprite.setTexture(superWaveTex);
 
         // MASTERCLASS: Use frame calculation like 8.png vacuum beam
-        int fh = superWaveTex.getSize().y;
+        int fh = sheetSize(superWaveTex).y;
         int fw = fh; // Square frames based on height
-        int totalFrames = std::max(1, (int)superWaveTex.getSize().x / fw);
+        int totalFrames = std::max(1, (int)sheetSize(superWaveTex).x / fw);
         sw.frames = totalFrames;
 
         int frameIdx = 0; // Start from first frame
@@ -4806,21 +8035,17 @@ private:
         float rangeBonus = (player.powerBoostTimer > 0) ? 1.4f : 1.0f;
         sw.sprite.setScale(rangeBonus, pulse);
 
-        // Store animation rects for animated effect
-        sw.customRects.clear();
-        for (int i = 0; i < totalFrames; ++i)
-        {
-            sw.customRects.push_back(IntRect(i * fw, 0, fw, fh));
-        }
+        // Animated through the shared super wave clip
+        sw.clip = superWaveClip;
 
-        effects.push_back(sw);
+        effects.spawn(std::move(sw));
     }
 
     void createRainbowShotEffect()
     {
         Effect rs;
         rs.timer = 0;
-        rs.frames = (int)effectMetaRects["8"].size() > 0 ? (int)effectMetaRects["8"].size() : 11;
+        rs.frames = (int)effectRects(8).size() > 0 ? (int)effectRects(8).size() : 11;
         rs.fps = 18.0f;
         rs.index = 0;
         rs.active = true;
@@ -4829,42 +8054,30 @@ private:
 
         rs.sprite.setTexture(rainbowShotTex);
 
-        if (!effectMetaRects["8"].empty())
+        if (!effectRects(8).empty())
         {
-            IntRect r = effectMetaRects["8"][0];
+            IntRect r = effectRects(8)[0];
             rs.sprite.setTextureRect(r);
             int dirNow = player.vacuumDirection;
-            bool aimRight = Keyboard::isKeyPressed(Keyboard::D);
-            bool aimUp = Keyboard::isKeyPressed(Keyboard::W);
-            bool aimLeft = Keyboard::isKeyPressed(Keyboard::A);
-            bool aimDown = Keyboard::isKeyPressed(Keyboard::S);
-            if (!aimRight && !aimUp && !aimLeft && !aimDown)
+            if (!input.aiming())
                 dirNow = player.facingRight ? 0 : 2;
             // strict compliance: no origin; compute adjusted position
-            rs.customRects = effectMetaRects["8"];
+            rs.clip = effectClips[8];
         }
         else
         {
-            int fw = rainbowShotTex.getSize().x / rs.frames;
-            int fh = rainbowShotTex.getSize().y;
+            int fw = sheetSize(rainbowShotTex).x / rs.frames;
+            int fh = sheetSize(rainbowShotTex).y;
             rs.sprite.setTextureRect(IntRect(0, 0, fw, fh));
             int dirNow = player.vacuumDirection;
-            bool aimRight = Keyboard::isKeyPressed(Keyboard::D);
-            bool aimUp = Keyboard::isKeyPressed(Keyboard::W);
-            bool aimLeft = Keyboard::isKeyPressed(Keyboard::A);
-            bool aimDown = Keyboard::isKeyPressed(Keyboard::S);
-            if (!aimRight && !aimUp && !aimLeft && !aimDown)
+            if (!input.aiming())
                 dirNow = player.facingRight ? 0 : 2;
             // strict compliance: no origin; compute adjusted position
         }
 
         float scaleX = 1.0f;
         int dirNow2 = player.vacuumDirection;
-        bool aimRight2 = Keyboard::isKeyPressed(Keyboard::D);
-        bool aimUp2 = Keyboard::isKeyPressed(Keyboard::W);
-        bool aimLeft2 = Keyboard::isKeyPressed(Keyboard::A);
-        bool aimDown2 = Keyboard::isKeyPressed(Keyboard::S);
-        if (!aimRight2 && !aimUp2 && !aimLeft2 && !aimDown2)
+        if (!input.aiming())
             dirNow2 = player.facingRight ? 0 : 2;
         switch (dirNow2)
         {
@@ -4923,14 +8136,14 @@ private:
         rs.sprite.setPosition(px, py);
         rs.sprite.setScale(scaleX, VACUUM_EFFECT_THICKNESS * (player.rangeBoostTimer > 0 ? 1.70f : 1.0f));
 
-        effects.push_back(rs);
+        effects.spawn(std::move(rs));
     }
 
     void createFlashEffect(float x, float y)
     {
         Effect e;
         e.timer = 0;
-        e.frames = (int)effectMetaRects["3"].size() > 0 ? (int)effectMetaRects["3"].size() : 3;
+        e.frames = (int)effectRects(3).size() > 0 ? (int)effectRects(3).size() : 3;
         e.fps = 18.0f;
         e.index = 0;
         e.active = true;
@@ -4940,68 +8153,68 @@ private:
         e.lifetime = 0;
         e.sprite.setTexture(flashTex);
         e.tex = &flashTex;
-        if (!effectMetaRects["3"].empty())
+        if (!effectRects(3).empty())
         {
-            IntRect r = effectMetaRects["3"][0];
+            IntRect r = effectRects(3)[0];
             e.sprite.setTextureRect(r);
             e.frameW = r.width;
             e.texH = r.height;
         }
         else
         {
-            int fw = flashTex.getSize().x / e.frames;
-            e.sprite.setTextureRect(IntRect(0, 0, fw, flashTex.getSize().y));
+            int fw = sheetSize(flashTex).x / e.frames;
+            e.sprite.setTextureRect(IntRect(0, 0, fw, sheetSize(flashTex).y));
             e.frameW = fw;
-            e.texH = (int)flashTex.getSize().y;
+            e.texH = (int)sheetSize(flashTex).y;
         }
         e.sprite.setPosition(x - (e.frameW * EFFECT_SCALE) / 2.0f,
                              y - (e.texH * EFFECT_SCALE) / 2.0f);
         e.sprite.setScale(EFFECT_SCALE, EFFECT_SCALE);
 
-        effects.push_back(e);
+        effects.spawn(std::move(e));
     }
 
     void createDebrisEffect(float x, float y)
     {
         Effect d;
         d.timer = 0;
-        d.frames = (int)effectMetaRects["9"].size() > 0 ? (int)effectMetaRects["9"].size() : 9;
+        d.frames = (int)effectRects(9).size() > 0 ? (int)effectRects(9).size() : 9;
         d.fps = 20.0f;
         d.index = 0;
         d.active = true;
-        d.vx = (rand() % 3 - 1) * 1.5f;
+        d.vx = (rngFx.below(3) - 1) * 1.5f;
         d.vy = -2.5f;
         d.gravity = 0.12f;
         d.lifetime = 0.6f;
 
         d.sprite.setTexture(debrisTex);
         d.tex = &debrisTex;
-        if (!effectMetaRects["9"].empty())
+        if (!effectRects(9).empty())
         {
-            IntRect r = effectMetaRects["9"][0];
+            IntRect r = effectRects(9)[0];
             d.sprite.setTextureRect(r);
             d.frameW = r.width;
             d.texH = r.height;
         }
         else
         {
-            int fw = debrisTex.getSize().x / d.frames;
-            d.sprite.setTextureRect(IntRect(0, 0, fw, debrisTex.getSize().y));
+            int fw = sheetSize(debrisTex).x / d.frames;
+            d.sprite.setTextureRect(IntRect(0, 0, fw, sheetSize(debrisTex).y));
             d.frameW = fw;
-            d.texH = (int)debrisTex.getSize().y;
+            d.texH = (int)sheetSize(debrisTex).y;
         }
         d.sprite.setPosition(x - (d.frameW * EFFECT_SCALE) / 2.0f,
                              y - (d.texH * EFFECT_SCALE) / 2.0f);
         d.sprite.setScale(EFFECT_SCALE, EFFECT_SCALE);
 
-        effects.push_back(d);
+        effects.spawn(std::move(d));
     }
 
     void createImpactEffect(float x, float y)
     {
         Effect e;
         e.timer = 0;
-        e.frames = (int)effectMetaRects["6"].size() > 0 ? (int)effectMetaRects["6"].size() : 5;
+        e.frames = (int)effectRects(6).size() > 0 ? (int)effectRects(6).size() : 5;
         e.fps = 20.0f;
         e.index = 0;
         e.active = true;
@@ -5012,30 +8225,30 @@ private:
 
         e.sprite.setTexture(impactTex);
         e.tex = &impactTex;
-        if (!effectMetaRects["6"].empty())
+        if (!effectRects(6).empty())
         {
-            IntRect r = effectMetaRects["6"][0];
+            IntRect r = effectRects(6)[0];
             e.sprite.setTextureRect(r);
             e.frameW = r.width;
             e.texH = r.height;
         }
         else
         {
-            int fw = impactTex.getSize().x / e.frames;
-            e.sprite.setTextureRect(IntRect(0, 0, fw, impactTex.getSize().y));
+            int fw = sheetSize(impactTex).x / e.frames;
+            e.sprite.setTextureRect(IntRect(0, 0, fw, sheetSize(impactTex).y));
             e.frameW = fw;
-            e.texH = (int)impactTex.getSize().y;
+            e.texH = (int)sheetSize(impactTex).y;
         }
         e.sprite.setPosition(x - (e.frameW * EFFECT_SCALE) / 2.0f,
                              y - (e.texH * EFFECT_SCALE) / 2.0f);
         e.sprite.setScale(EFFECT_SCALE, EFFECT_SCALE);
 
-        effects.push_back(e);
+        effects.spawn(std::move(e));
     }
 
     void createSkeletonHitEffect(float x, float y)
     {
-        if (skeletonTex.getSize().x == 0)
+        if (sheetSize(skeletonTex).x == 0)
             return;
         Effect e;
         e.timer = 0;
@@ -5050,45 +8263,27 @@ private:
         e.sprite.setTexture(skeletonTex);
         e.tex = &skeletonTex;
         int fw = ENEMY_FRAME_WIDTH;
-        int fh = skeletonTex.getSize().y;
-        for (int i = 19; i <= 24; ++i)
-            e.customRects.push_back(IntRect(i * fw, 0, fw, fh));
-        IntRect r = e.customRects.empty() ? IntRect(19 * fw, 0, fw, fh) : e.customRects[0];
+        int fh = sheetSize(skeletonTex).y;
+        e.clip = skeletonHitClip;
+        const std::vector<IntRect> &hit = AnimClipRegistry::shared().frames(e.clip);
+        IntRect r = hit.empty() ? IntRect(19 * fw, 0, fw, fh) : hit[0];
         e.sprite.setTextureRect(r);
         e.frameW = r.width;
         e.texH = r.height;
         e.sprite.setPosition(x - (e.frameW * EFFECT_SCALE) / 2.0f,
                              y - (e.texH * EFFECT_SCALE) / 2.0f);
         e.sprite.setScale(EFFECT_SCALE, EFFECT_SCALE);
-        effects.push_back(e);
+        effects.spawn(std::move(e));
     }
 
     void createVacuumPickupEffect(float x, float y)
     {
         Effect e;
         e.timer = 0;
-        // Use the 'disappear' label range from 2_meta.json
-        std::pair<int, int> range = std::make_pair(0, 0);
-        auto it = effectLabels.find("2");
-        if (it != effectLabels.end())
-        {
-            auto it2 = it->second.find("disappear");
-            if (it2 != it->second.end())
-                range = it2->second;
-        }
-
-        std::vector<IntRect> rects = effectMetaRects["2"];
-        int start = range.first;
-        int end = range.second;
-        start = std::max(0, start);
-        end = std::min((int)rects.size() - 1, end);
-        if (start > end)
-            start = end;
-
-        for (int i = start; i <= end; ++i)
-            e.customRects.push_back(rects[i]);
-
-        e.frames = (int)e.customRects.size() > 0 ? (int)e.customRects.size() : 1;
+        // Plays the 'disappear' range of 2.png, registered at load
+        e.clip = vacuumDisappearClip;
+        const std::vector<IntRect> &rects = AnimClipRegistry::shared().frames(e.clip);
+        e.frames = (int)rects.size() > 0 ? (int)rects.size() : 1;
         e.fps = 18.0f;
         e.index = 0;
         e.active = true;
@@ -5099,32 +8294,32 @@ private:
 
         e.sprite.setTexture(vacuumEffectTex);
         e.tex = &vacuumEffectTex;
-        if (!e.customRects.empty())
+        if (!rects.empty())
         {
-            IntRect r = e.customRects[0];
+            IntRect r = rects[0];
             e.sprite.setTextureRect(r);
             e.frameW = r.width;
             e.texH = r.height;
         }
         else
         {
-            int fw = vacuumEffectTex.getSize().x / e.frames;
-            e.sprite.setTextureRect(IntRect(0, 0, fw, vacuumEffectTex.getSize().y));
+            int fw = sheetSize(vacuumEffectTex).x / e.frames;
+            e.sprite.setTextureRect(IntRect(0, 0, fw, sheetSize(vacuumEffectTex).y));
             e.frameW = fw;
-            e.texH = (int)vacuumEffectTex.getSize().y;
+            e.texH = (int)sheetSize(vacuumEffectTex).y;
         }
         e.sprite.setPosition(x - (e.frameW * EFFECT_SCALE) / 2.0f,
                              y - (e.texH * EFFECT_SCALE) / 2.0f);
         e.sprite.setScale(EFFECT_SCALE, EFFECT_SCALE);
 
-        effects.push_back(e);
+        effects.spawn(std::move(e));
     }
 
     void createMysteryBoxEffect(float x, float y)
     {
         Effect e;
         e.timer = 0;
-        e.frames = (int)effectMetaRects["4"].size() > 0 ? (int)effectMetaRects["4"].size() : 7;
+        e.frames = (int)effectRects(4).size() > 0 ? (int)effectRects(4).size() : 7;
         e.fps = 16.0f;
         e.index = 0;
         e.active = true;
@@ -5134,30 +8329,31 @@ private:
         e.lifetime = 0;
 
         e.sprite.setTexture(mysteryBoxTex);
-        if (!effectMetaRects["4"].empty())
+        if (!effectRects(4).empty())
         {
-            IntRect r = effectMetaRects["4"][0];
+            IntRect r = effectRects(4)[0];
             e.sprite.setTextureRect(r);
             e.frameW = r.width;
             e.texH = r.height;
         }
         else
         {
-            int fw = mysteryBoxTex.getSize().x / e.frames;
-            e.sprite.setTextureRect(IntRect(0, 0, fw, mysteryBoxTex.getSize().y));
+            int fw = sheetSize(mysteryBoxTex).x / e.frames;
+            e.sprite.setTextureRect(IntRect(0, 0, fw, sheetSize(mysteryBoxTex).y));
             e.frameW = fw;
-            e.texH = (int)mysteryBoxTex.getSize().y;
+            e.texH = (int)sheetSize(mysteryBoxTex).y;
         }
         e.sprite.setPosition(x - (e.frameW * EFFECT_SCALE) / 2.0f,
                              y - (e.texH * EFFECT_SCALE) / 2.0f);
         e.sprite.setScale(EFFECT_SCALE, EFFECT_SCALE);
 
-        effects.push_back(e);
+        effects.spawn(std::move(e));
     }
 
     // Main render dispatcher for each game state
     void render()
     {
+        ProfileScope scope(profiler, PROF_RENDER);
         window.clear(Color(20, 20, 40));
 
         switch (state)
@@ -5177,14 +8373,49 @@ private:
             break;
         }
 
+        if (showProfiler)
+            renderProfiler();
+
         window.display();
     }
 
+    // F3 overlay: rolling min/avg/p99 per section over the last few seconds
+    void renderProfiler()
+    {
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(2) << "section        min    avg    p99 (ms)\n";
+        for (int s = 0; s < PROF_SECTION_COUNT; s++)
+        {
+            Profiler::Stats st = profiler.stats(s);
+            ss << std::left << std::setw(13) << Profiler::name(s) << std::right
+               << std::setw(6) << st.min << " " << std::setw(6) << st.avg << " " << std::setw(6) << st.p99 << "\n";
+        }
+        ss << "draw calls " << spriteBatch.getLastDrawCalls() << "  quads " << spriteBatch.getLastQuads()
+           << "  particles " << particles.count() << "\n";
+        ss << "pool drops  shots " << projectiles.dropped() << "  enemy " << enemyProjectiles.dropped()
+           << "  fx " << effects.dropped() << "\n";
+        ss << "layer        drawn culled";
+        for (int l = 0; l < SpriteBatch::LAYER_COUNT; l++)
+        {
+            if (l == SpriteBatch::LAYER_HUD)
+                continue;
+            ss << "\n" << std::left << std::setw(13) << SpriteBatch::name(l) << std::right
+               << std::setw(5) << camera.lastVisible(l) << " " << std::setw(6) << camera.lastCulledCount(l);
+        }
+
+        Text text(ss.str(), gameFont, 14);
+        text.setFillColor(Color::White);
+        text.setPosition(SCREEN_WIDTH - 340.0f, 90.0f);
+        FloatRect b = text.getGlobalBounds();
+        drawRectTex(uiPxBlack120Tex, b.left - 8, b.top - 8, b.width + 16, b.height + 16);
+        window.draw(text);
+    }
+
     void renderCharacterSelect()
     {
         bgSprite.setTexture(bgTex);
-        bgSprite.setScale((float)SCREEN_WIDTH / bgTex.getSize().x,
-                          (float)SCREEN_HEIGHT / bgTex.getSize().y);
+        bgSprite.setScale((float)SCREEN_WIDTH / sheetSize(bgTex).x,
+                          (float)SCREEN_HEIGHT / sheetSize(bgTex).y);
         window.draw(bgSprite);
 
         drawRectTex(uiPxBlack120Tex, 0, 0, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT);
@@ -5256,14 +8487,14 @@ private:
         }
 
         // Sweep effect for selected yellow
-        if (selectedCharacter == 0 && uiSweep18Tex.getSize().x > 0)
+        if (selectedCharacter == 0 && sheetSize(uiSweep18Tex).x > 0)
         {
             Sprite sweep(uiSweep18Tex);
-            sweep.setTextureRect(IntRect(0, 0, (int)uiSweep18Tex.getSize().x, (int)uiSweep18Tex.getSize().y));
+            sweep.setTextureRect(IntRect(0, 0, (int)sheetSize(uiSweep18Tex).x, (int)sheetSize(uiSweep18Tex).y));
             float sx = leftBoxX - boxWidth * 0.15f + fmod(characterSelectTimer * 280.0f, boxWidth + 350);
             float sy = boxY - 25 + yellowBounce;
             sweep.setPosition(sx, sy);
-            window.draw(sweep);
+            drawSprite(window, sweep);
         }
 
         // GREEN box (RIGHT) - MASTERCLASS enhanced with glow effect
@@ -5288,21 +8519,21 @@ private:
         }
 
         // Sweep effect for selected green
-        if (selectedCharacter == 1 && uiSweep18Tex.getSize().x > 0)
+        if (selectedCharacter == 1 && sheetSize(uiSweep18Tex).x > 0)
         {
             Sprite sweep(uiSweep18Tex);
-            sweep.setTextureRect(IntRect(0, 0, (int)uiSweep18Tex.getSize().x, (int)uiSweep18Tex.getSize().y));
+            sweep.setTextureRect(IntRect(0, 0, (int)sheetSize(uiSweep18Tex).x, (int)sheetSize(uiSweep18Tex).y));
             float sx = rightBoxX - boxWidth * 0.15f + fmod(characterSelectTimer * 280.0f, boxWidth + 350);
             float sy = boxY - 25 + greenBounce;
             sweep.setPosition(sx, sy);
-            window.draw(sweep);
+            drawSprite(window, sweep);
         }
 
         // MASTERCLASS: Much larger animated character previews
         auto getFrameRect = [&](Texture &tex, int idx)
         {
-            int w = (int)tex.getSize().x;
-            int h = (int)tex.getSize().y;
+            int w = (int)sheetSize(tex).x;
+            int h = (int)sheetSize(tex).y;
             int fw = PLAYER_FRAME_WIDTH;
             int frames = std::max(1, w / fw);
             idx = std::max(0, std::min(idx, frames - 1));
@@ -5313,7 +8544,7 @@ private:
         int frame = ((int)(characterSelectTimer * 8)) % 4 + 4; // Faster animation
 
         // YELLOW PLAYER - MASTERCLASS: Much larger with breathing effect
-        if (yellowRow1Tex.getSize().x > 0)
+        if (sheetSize(yellowRow1Tex).x > 0)
         {
             Sprite yellowPreview;
             yellowPreview.setTexture(yellowRow1Tex);
@@ -5330,11 +8561,11 @@ private:
             float previewY = boxY + boxHeight * 0.42f + yellowBounce; // Positioned higher
             yellowPreview.setPosition(previewX - (r.width * finalScale) / 2.0f,
                                       previewY - (r.height * finalScale) / 2.0f);
-            window.draw(yellowPreview);
+            drawSprite(window, yellowPreview);
         }
 
         // GREEN PLAYER - MASTERCLASS: Much larger with breathing effect
-        if (greenRow1Tex.getSize().x > 0)
+        if (sheetSize(greenRow1Tex).x > 0)
         {
             Sprite greenPreview;
             greenPreview.setTexture(greenRow1Tex);
@@ -5350,7 +8581,7 @@ private:
             float previewY = boxY + boxHeight * 0.42f + greenBounce; // Positioned higher
             greenPreview.setPosition(previewX - (r.width * finalScale) / 2.0f,
                                      previewY - (r.height * finalScale) / 2.0f);
-            window.draw(greenPreview);
+            drawSprite(window, greenPreview);
         }
 
         // MASTERCLASS: Enhanced text layout for larger boxes
@@ -5425,92 +8656,32 @@ private:
     // Renders the gameplay scene including player, enemies, HUD, and effects
     void renderGameplay()
     {
-        display_level(window, mapPtr(), (currentLevel == 2 ? bg2Tex : bgTex), bgSprite, platformTex, platformSprite, LEVEL_HEIGHT, LEVEL_WIDTH, CELL_SIZE);
-
-        // '#' blocks already drawn by display_level; draw ramps and slants next
-
-        // Draw a smooth ramp for the pre-defined 'S' staircase using dense sprite strips
-        {
-            int sr = 4, sc = 12;
-            int er = 9, ec = 7;
-            if (levelMap[sr][sc] == 'S' && levelMap[er][ec] == 'S' && platformTex.getSize().x > 0)
-            {
-                int x1 = sc * CELL_SIZE;
-                int y1 = platformTopYAt(sr, sc);
-                int x2 = ec * CELL_SIZE;
-                int y2 = platformTopYAt(er, ec);
-                int thick = (int)(CELL_SIZE * 0.8f);
-                float dx = (float)(x2 - x1);
-                float dy = (float)(y2 - y1);
-                float len = std::max(1.0f, std::sqrt(dx * dx + dy * dy));
-                int stepPix = 2;
-                int steps = std::max(1, (int)(len / stepPix));
-                for (int k = 0; k < steps; ++k)
-                {
-                    float t = k / (float)steps;
-                    float bx = x1 + dx * t;
-                    float by = y1 + dy * t;
-                    int texW = (int)platformTex.getSize().x;
-                    int texH = (int)platformTex.getSize().y;
-                    int sw = 2;
-                    int srcX = (k * sw) % std::max(1, texW);
-                    Sprite slice(platformTex);
-                    slice.setTextureRect(IntRect(srcX, 0, sw, texH));
-                    slice.setScale(1.0f, (float)thick / texH);
-                    slice.setPosition((int)bx, (int)by - thick / 2);
-                    window.draw(slice);
-                }
-            }
-        }
-
-        // Draw smooth ramps for randomized slants using dense sprite strips
-        if (platformTex.getSize().x > 0)
-        {
-            int thick = (int)(CELL_SIZE * 0.8f);
-            for (int i = 0; i < LEVEL_HEIGHT; ++i)
-            {
-                int j = 0;
-                while (j < LEVEL_WIDTH)
-                {
-                    char cell = levelMap[i][j];
-                    if (cell == '/' || cell == '\\')
-                    {
-                        // Aggregate contiguous slant segment [startCol..endCol]
-                        int startCol = j;
-                        while (j + 1 < LEVEL_WIDTH && levelMap[i][j + 1] == cell)
-                            ++j;
-                        int endCol = j;
-                        int x1 = startCol * CELL_SIZE;
-                        int y1 = platformTopYAt(i, startCol);
-                        int x2 = endCol * CELL_SIZE;
-                        int y2 = platformTopYAt(i, endCol);
-                        float dx = (float)(x2 - x1);
-                        float dy = (float)(y2 - y1);
-                        float len = std::max(1.0f, std::sqrt(dx * dx + dy * dy));
-                        int stepPix = 2;
-                        int steps = std::max(1, (int)(len / stepPix));
-                        for (int k = 0; k < steps; ++k)
-                        {
-                            float t = k / (float)steps;
-                            float bx = x1 + dx * t;
-                            float by = y1 + dy * t;
-                            int texW = (int)platformTex.getSize().x;
-                            int texH = (int)platformTex.getSize().y;
-                            int sw = 2;
-                            int srcX = (k * sw) % std::max(1, texW);
-                            Sprite slice(platformTex);
-                            slice.setTextureRect(IntRect(srcX, 0, sw, texH));
-                            slice.setScale(1.0f, (float)thick / texH);
-                            slice.setPosition((int)bx, (int)by - thick / 2);
-                            window.draw(slice);
-                        }
-                    }
-                    ++j;
-                }
-            }
-        }
+        ProfileScope scope(profiler, PROF_LEVEL);
+        // Follow where the player is drawn this frame, not where the last step left it
+        Vector2f lerped = player.lerp.offset(renderAlpha);
+        camera.follow(player.getCenterX() + lerped.x, player.getCenterY() + lerped.y);
+        display_level(window, (levelData(currentLevel).background == 2 ? bg2Tex : bgTex), bgSprite, platformTex,
+                      terrain, camera.getView());
+
+        // '#' blocks already drawn by display_level; ramps and slants come from the
+        // per-chunk caches built in buildRampMesh()
+        scope.next(PROF_RAMPS);
+        FloatRect visible = camera.bounds();
+        for (size_t i = 0; i < terrain.size(); i++)
+        {
+            if (terrain[i].ramps.getVertexCount() > 0 && terrain[i].bounds.intersects(visible))
+                window.draw(terrain[i].ramps, RenderStates(&platformTex));
+        }
+        window.setView(window.getDefaultView());
+
+        // Everything below goes through the sprite batch and is flushed per layer;
+        // world layers through the camera, the HUD in screen space
+        scope.next(PROF_ENTITIES);
+        spriteBatch.begin();
+        spriteBatch.setWorldView(camera.getView());
 
         // Draw powerups with alignment to nearest platform top
+        spriteBatch.setLayer(SpriteBatch::LAYER_POWERUPS);
         for (size_t i = 0; i < powerups.size(); i++)
         {
             if (powerups[i].active)
@@ -5520,9 +8691,9 @@ private:
                     int col = (int)((powerups[i].x + 24) / CELL_SIZE);
                     int bestRow = -1;
                     int bestDist = 1000000;
-                    for (int r = 0; r < LEVEL_HEIGHT; ++r)
+                    for (int r = 0; r < levelHeight; ++r)
                     {
-                        if (col >= 0 && col < LEVEL_WIDTH && levelMap[r][col] == '#')
+                        if (tileGrid.has(r, col, TILE_SOLID))
                         {
                             int visOffset = (r == 11) ? 22 : 0;
                             int targetY = r * CELL_SIZE - 17 - visOffset;
@@ -5541,43 +8712,48 @@ private:
                         float bob = sin(powerups[i].bobTimer * 3.0f) * 5.0f;
                         powerups[i].sprite.setPosition(powerups[i].x, targetY + bob);
                     }
-                    window.draw(powerups[i].sprite);
+                    if (camera.cull(SpriteBatch::LAYER_POWERUPS, powerups[i].sprite.getGlobalBounds()))
+                        drawSprite(window, powerups[i].sprite);
                 }
             }
         }
 
         // Draw active, uncaptured enemies
+        spriteBatch.setLayer(SpriteBatch::LAYER_ENEMIES);
         for (size_t i = 0; i < enemies.size(); i++)
         {
-            Enemy &e = enemies[i];
-            if (e.active && !e.captured)
+            if (enemies.hot.live(i))
             {
-                window.draw(e.sprite);
+                Enemy &e = enemies[i];
+                drawLerped(e.sprite, e.lerp);
             }
         }
 
         // Draw enemy projectiles (bombs, heads), fallback to circle if missing texture
+        spriteBatch.setLayer(SpriteBatch::LAYER_ENEMY_SHOTS);
         for (size_t i = 0; i < enemyProjectiles.size(); i++)
         {
             EnemyProjectile &ep = enemyProjectiles[i];
             if (ep.active)
             {
                 {
-                    window.draw(ep.sprite);
+                    drawLerped(ep.sprite, ep.lerp);
                 }
             }
         }
 
         // Draw player projectiles (rolling balls and aerial shots)
+        spriteBatch.setLayer(SpriteBatch::LAYER_PROJECTILES);
         for (size_t i = 0; i < projectiles.size(); i++)
         {
             if (projectiles[i].active)
             {
-                window.draw(projectiles[i].sprite);
+                drawLerped(projectiles[i].sprite, projectiles[i].lerp);
             }
         }
 
         // Draw vacuum beam or trail effect when active
+        spriteBatch.setLayer(SpriteBatch::LAYER_PLAYER);
         if ((player.vacuumActive || vacuumTrailTimer > 0) && vacuumSuppressTimer <= 0)
         {
             drawVacuumEffect();
@@ -5594,7 +8770,7 @@ private:
                 player.sprite.setPosition(pOldX - (PLAYER_FRAME_WIDTH * PLAYER_SCALE) / 2.0f,
                                           pOldY - 22 - (PLAYER_FRAME_HEIGHT * PLAYER_SCALE));
             }
-            window.draw(player.sprite);
+            drawLerped(player.sprite, player.lerp);
             if (footRow == 11)
             {
                 player.sprite.setPosition(pOldX - (PLAYER_FRAME_WIDTH * PLAYER_SCALE) / 2.0f,
@@ -5603,16 +8779,24 @@ private:
         }
 
         // Draw heads-up display (score, level, health blocks)
+        spriteBatch.setLayer(SpriteBatch::LAYER_HUD);
+        scope.next(PROF_HUD);
         renderHUD();
 
         // Draw transient visual effects (impacts, pickups, debris)
+        scope.next(PROF_ENTITIES);
+        spriteBatch.setLayer(SpriteBatch::LAYER_EFFECTS);
         for (size_t i = 0; i < effects.size(); i++)
         {
             Effect &e = effects[i];
             if (!e.active)
                 continue;
-            window.draw(e.sprite);
+            drawLerped(e.sprite, e.lerp);
         }
+
+        scope.next(PROF_FLUSH);
+        spriteBatch.end(window);
+        camera.endFrame();
     }
 
     void drawVacuumEffect()
@@ -5621,10 +8805,10 @@ private:
             return;
 
         // Determine direction (Priority: WASD > Facing)
-        bool kW = Keyboard::isKeyPressed(Keyboard::W);
-        bool kA = Keyboard::isKeyPressed(Keyboard::A);
-        bool kS = Keyboard::isKeyPressed(Keyboard::S);
-        bool kD = Keyboard::isKeyPressed(Keyboard::D);
+        bool kW = input.down(InputState::AIM_UP);
+        bool kA = input.down(InputState::AIM_LEFT);
+        bool kS = input.down(InputState::AIM_DOWN);
+        bool kD = input.down(InputState::AIM_RIGHT);
         int vacDir = -1;
         if (kD)
             vacDir = 0; // Right
@@ -5660,7 +8844,7 @@ private:
             frameIdx = 0;
 
         Sprite beamSprite(*useTex);
-        int fh = useTex->getSize().y;
+        int fh = sheetSize(*useTex).y;
         beamSprite.setTextureRect(IntRect(frameIdx * useFrameW, 0, useFrameW, fh));
 
         // Origin: Left Center
@@ -5708,7 +8892,7 @@ private:
         float rangeBonus = (player.powerBoostTimer > 0) ? 1.4f : 1.0f;
         beamSprite.setScale(rangeBonus, pulse);
 
-        window.draw(beamSprite);
+        drawSprite(window, beamSprite);
     }
 
     // Renders player portrait, label, health line, and colored health blocks
@@ -5776,7 +8960,7 @@ private:
                 p.setTextureRect(prC);
                 p.setPosition(baseX, baseY - 30);
                 p.setScale(1.45f, 1.45f);
-                window.draw(p);
+                drawSprite(window, p);
                 baseX += prC.width * 1.45f + 8;
             }
 
@@ -5789,7 +8973,7 @@ private:
                 s.setTextureRect(lrC);
                 s.setPosition(baseX, baseY - 30);
                 s.setScale(1.45f, 1.45f);
-                window.draw(s);
+                drawSprite(window, s);
                 baseX += lrC.width * 1.45f + 12;
             }
 
@@ -5801,7 +8985,7 @@ private:
                 bar.setTextureRect(brC);
                 bar.setPosition(baseX, baseY);
                 bar.setScale(1.15f, 1.15f);
-                window.draw(bar);
+                drawSprite(window, bar);
 
                 float barW = brC.width * 1.15f;
                 float blockSize = 24.0f;
@@ -5820,7 +9004,7 @@ private:
                     blk.setScale(blockSize / (float)hb.width, blockSize / (float)hb.height);
                     if (i >= shown)
                         blk.setScale(0, 0); // hide depleted blocks
-                    window.draw(blk);
+                    drawSprite(window, blk);
                 }
             }
         }
@@ -5861,7 +9045,7 @@ private:
             int remaining = 0;
             for (size_t i = 0; i < enemies.size(); i++)
             {
-                if (enemies[i].active && !enemies[i].captured)
+                if (enemies.hot.live(i))
                     remaining++;
             }
 
@@ -5881,6 +9065,9 @@ private:
             numText.setFillColor((remaining <= 3) ? Color::Green : (remaining <= 6) ? Color::Yellow
                                                                                     : Color::White);
             numText.setPosition(startX + enemyLabelW + 5, 52);
+            // TTF text can't join the batch; flush what's queued so it stays underneath
+            if (spriteBatch.isOpen())
+                spriteBatch.flush(window);
             window.draw(numText);
 
             // Captured enemies indicator
@@ -5958,7 +9145,7 @@ private:
 // ============================================================================
 // MAIN
 // ============================================================================
-int main()
+int main(int argc, char *argv[])
 {
     cout << "\n========================================" << endl;
     cout << " TUMBLEPOP - MASTERCLASS EDITION v8.0 " << endl;
@@ -5966,23 +9153,65 @@ int main()
     cout << "========================================\n"
          << endl;
 
+    // --headless [--script file] [--ticks n] [--sessions n] [--seed n]
+    // --record file | --replay file [--speed x]
+    // --trace file (Chrome trace of profiler sections; F3 shows the overlay)
+    // --levels dir (default Data/Levels; Data/Levels/wide is a scrolling test set)
+    // --compile-levels (<levels dir>/*.txt -> .lvb, then exit)
+    GameOptions options;
+    bool compileOnly = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--compile-levels")
+            compileOnly = true;
+        else if (arg == "--levels" && i + 1 < argc)
+            options.levelDir = argv[++i];
+        else if (arg == "--headless")
+            options.headless = true;
+        else if (arg == "--script" && i + 1 < argc)
+            options.scriptPath = argv[++i];
+        else if (arg == "--ticks" && i + 1 < argc)
+            options.maxTicks = std::max(1, atoi(argv[++i]));
+        else if (arg == "--sessions" && i + 1 < argc)
+            options.sessions = std::max(1, atoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc)
+            options.seed = std::max(0LL, atoll(argv[++i]));
+        else if (arg == "--record" && i + 1 < argc)
+            options.recordPath = argv[++i];
+        else if (arg == "--replay" && i + 1 < argc)
+            options.replayPath = argv[++i];
+        else if (arg == "--trace" && i + 1 < argc)
+            options.tracePath = argv[++i];
+        else if (arg == "--speed" && i + 1 < argc)
+            options.replaySpeed = std::max(0.1f, (float)atof(argv[++i]));
+        else
+            cout << "[WARN] Ignoring argument " << arg << endl;
+    }
+    if (compileOnly)
+        return compile_levels(options.levelDir);
+
+    Logger::instance().start();
     try
     {
-        Game game;
+        Game game(options);
         game.run();
     }
     catch (const exception &e)
     {
+        Logger::instance().stop();
         cout << "ERROR: " << e.what() << endl;
-        cin.get();
+        if (!options.headless)
+            cin.get();
         return 1;
     }
 
+    Logger::instance().stop();
     return 0;
 }
 void Game::drawSpriteText(RenderWindow &w, const std::string &text, float x, float y, float scale, Color color)
 {
-    if (!useSpriteText || uiFontTex.getSize().x == 0)
+    if (!useSpriteText || sheetSize(uiFontTex).x == 0)
         return;
     Sprite s(uiFontTex);
     float cx = x;
@@ -5999,13 +9228,13 @@ void Game::drawSpriteText(RenderWindow &w, const std::string &text, float x, flo
         s.setPosition(cx, y);
         s.setScale(scale, scale);
         // strict compliance: color is encoded in texture
-        w.draw(s);
+        drawSprite(w, s);
         cx += it->second.width * scale;
     }
 }
 float Game::spriteTextWidth(const std::string &text, float scale)
 {
-    if (!useSpriteText || uiFontTex.getSize().x == 0)
+    if (!useSpriteText || sheetSize(uiFontTex).x == 0)
         return 0;
     float w = 0;
     for (char c : text)
@@ -6022,11 +9251,35 @@ float Game::spriteTextWidth(const std::string &text, float scale)
 }
 void Game::drawRectTex(Texture &tex, float x, float y, float rw, float rh)
 {
-    if (tex.getSize().x == 0)
+    if (sheetSize(tex).x == 0)
         return;
     Sprite s(tex);
     s.setTextureRect(IntRect(0, 0, 1, 1));
     s.setPosition(x, y);
     s.setScale(rw, rh);
-    window.draw(s);
+    drawSprite(window, s);
+}
+// Draws a sprite through the atlas when its sheet was packed, so consecutive
+// draws from different sheets keep the same texture bound. While the sprite
+// batch is open the quad is queued instead of drawn immediately.
+void Game::drawSprite(RenderTarget &target, const Sprite &sprite)
+{
+    const Texture *page = nullptr;
+    IntRect rect = sprite.getTextureRect();
+    if (spriteBatch.isOpen() && sprite.getTexture())
+    {
+        if (!atlas.remap(sprite.getTexture(), page, rect))
+            page = sprite.getTexture();
+        spriteBatch.add(page, rect, sprite.getTransform(), sprite.getColor());
+        return;
+    }
+    if (sprite.getTexture() && atlas.remap(sprite.getTexture(), page, rect))
+    {
+        Sprite mapped(sprite);
+        mapped.setTexture(*page);
+        mapped.setTextureRect(rect);
+        target.draw(mapped);
+        return;
+    }
+    target.draw(sprite);
 }